@@ -0,0 +1,97 @@
+/**
+ * @file bench.cpp
+ * @author Jiri Kristof <xkrist22@stud.fit.vutbr.cz>
+ * @brief File contains microbenchmark of local list ranking kernels of project "preorder tree"
+ *
+ * usage: bench [LENGTH] [RUNS] [REPEAT]
+ *   list of LENGTH elements is split to RUNS runs (as block of edges
+ *   with successors in other blocks), successors are shuffled, so
+ *   gathers do not hit cache lines of neighbours, every kernel ranks
+ *   list REPEAT times and the best time is printed, last line is first
+ *   ranking by automatically chosen kernel, elements are index_t as in
+ *   pipeline (32-bit only if built with -DINDEX32)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include "kernel.h"
+#include "tree.h"
+
+using namespace std;
+
+// default size of benchmark
+#define BENCH_LENGTH 1000000
+#define BENCH_RUNS 16
+#define BENCH_REPEAT 5
+
+int main(int argc, char** argv) {
+	index_t length = argc > 1 ? atoll(argv[1]) : BENCH_LENGTH;
+	int runs = argc > 2 ? atoi(argv[2]) : BENCH_RUNS;
+	int repeat = argc > 3 ? atoi(argv[3]) : BENCH_REPEAT;
+	if (length < 1 || runs < 1 || runs > length || repeat < 1) {
+		fprintf(stderr, "invalid arguments\n");
+		return 1;
+	}
+
+	// elements are visited in random order, every run ends by sentinel
+	vector<index_t> order(length);
+	for (index_t i = 0; i < length; i++) {
+		order[i] = i;
+	}
+	mt19937 generator(length);
+	shuffle(order.begin(), order.end(), generator);
+	index_t run_length = (length + runs - 1) / runs;
+	vector<index_t> weight(length + 1, 0), tail(length + 1, 0), next(length + 1, length);
+	for (index_t i = 0; i < length; i++) {
+		weight[order[i]] = generator() % 2;
+		if (i == length - 1 || (i + 1) % run_length == 0) {
+			tail[order[i]] = i + 1;
+		} else {
+			next[order[i]] = order[i + 1];
+		}
+	}
+
+	printf("kernel time[ms] speedup\n");
+	double scalar_time = 0;
+	vector<index_t> expected;
+	for (int kernel = LOCAL_KERNEL_SCALAR; kernel < LOCAL_KERNELS_COUNT; kernel++) {
+		if (!local_kernel_available(kernel)) {
+			printf("%s unavailable\n", local_kernel_name(kernel));
+			continue;
+		}
+		double best = 0;
+		vector<index_t> result;
+		for (int r = 0; r < repeat; r++) {
+			vector<index_t> w(weight), t(tail), n(next);
+			auto start = chrono::steady_clock::now();
+			local_list_rank(w, t, n, kernel);
+			double time = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+			if (r == 0 || time < best) {
+				best = time;
+			}
+			result = w;
+			result.insert(result.end(), t.begin(), t.end());
+		}
+		if (kernel == LOCAL_KERNEL_SCALAR) {
+			scalar_time = best;
+			expected = result;
+		} else if (result != expected) {
+			fprintf(stderr, "%s kernel gives wrong result\n", local_kernel_name(kernel));
+			return 1;
+		}
+		printf("%s %.3f %.2f\n", local_kernel_name(kernel), best, scalar_time / best);
+	}
+
+	// first automatic ranking includes measuring of kernels
+	vector<index_t> w(weight), t(tail), n(next);
+	auto start = chrono::steady_clock::now();
+	local_list_rank(w, t, n);
+	double time = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+	int chosen = local_kernel_best(sizeof(index_t));
+	printf("%s(%s) %.3f %.2f\n", local_kernel_name(LOCAL_KERNEL_AUTO),
+		local_kernel_name(chosen == LOCAL_KERNEL_AUTO ? LOCAL_KERNEL_SCALAR : chosen), time, scalar_time / time);
+	return 0;
+}
@@ -0,0 +1,13 @@
+#!/bin/bash
+
+# setup
+# usage: bench.sh [LENGTH] [RUNS] [REPEAT]
+# compares scalar and vectorized kernels of local list ranking
+
+# compile
+mpic++ -O2 -o bench bench.cpp kernel.cpp
+
+# execute
+./bench "$@"
+# teardown
+rm -f bench
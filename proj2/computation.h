@@ -0,0 +1,621 @@
+/**
+ * @file computation.h
+ * @author Jiri Kristof, <xkrist22@stud.fit.vutbr.cz>
+ * @brief header file of generic euler tour computations of project "preorder tree"
+ *
+ * preorder is only one of computations, which consist of euler tour,
+ * weights of edges, suffix sum by associative operator and mapping
+ * of sums to values of nodes, this file contains templates, which
+ * make weights, operator and mapping parameters
+ */
+
+#ifndef COMPUTATION_H
+#define COMPUTATION_H
+
+#include <functional>
+#include "pro.h"
+#include "profile.h"
+
+// names of predefined tree numbers (see Tree_numbers_map)
+#define NUMBER_PRE "pre"
+#define NUMBER_POST "post"
+#define NUMBER_DEPTH "depth"
+#define NUMBER_SIZE "size"
+#define NUMBER_DESC "desc"
+
+// separator of names given by -c flag
+#define NUMBERS_SEPARATOR ','
+
+// number of predefined tree numbers and number of weights needed by them
+#define NUMBERS_COUNT 5
+#define NUMBERS_WEIGHTS 2
+
+/**
+ * Class represents vector of values combined elementwise, so several
+ * computations can share one sweep of suffix sum
+ */
+template<typename T, int K>
+class Tour_vector {
+	private:
+		T value[K];
+	public:
+		/**
+		 * Constructor of vector, every component is set to given value
+		 * @param value initial value of components
+		 */
+		Tour_vector(T value = T()) {
+			for (int i = 0; i < K; i++) {
+				this->value[i] = value;
+			}
+		}
+
+		/**
+		 * Operators give access to components
+		 * @param i index of component
+		 * @return component of vector
+		 */
+		T &operator[](int i) {
+			return this->value[i];
+		}
+
+		const T &operator[](int i) const {
+			return this->value[i];
+		}
+
+		/**
+		 * Operator adds vectors elementwise
+		 * @param other second vector
+		 * @return vector of sums of components
+		 */
+		Tour_vector operator+(const Tour_vector &other) const {
+			Tour_vector result;
+			for (int i = 0; i < K; i++) {
+				result.value[i] = this->value[i] + other.value[i];
+			}
+			return result;
+		}
+};
+
+/**
+ * Class represents computation over euler tour
+ *
+ * value of node is mapped from sums of suffixes starting by forward
+ * edge going into node (down) and by reverse edge going from node (up),
+ * combine operator must be associative and identity must be its neutral
+ * element (ending edge gets identity instead of its weight)
+ *
+ * @tparam Value type of weights and sums
+ * @tparam Weight functor Value(index_t edge_id, bool forward)
+ * @tparam Combine functor Value(const Value &, const Value &)
+ * @tparam Map functor Result(const Value &down, const Value &up)
+ */
+template<typename Value, typename Weight, typename Combine, typename Map>
+class Tour_computation {
+	private:
+		Value identity;
+		Weight weight_fn;
+		Combine combine_fn;
+		Map map_fn;
+	public:
+		typedef Value value_t;
+		typedef decltype(declval<Map>()(declval<Value>(), declval<Value>())) result_t;
+
+		/**
+		 * Constructor of computation
+		 * @param identity neutral element of combine operator
+		 * @param weight assignment of weights to edges
+		 * @param combine associative operator
+		 * @param map mapping of sums to value of node
+		 */
+		Tour_computation(Value identity, Weight weight, Combine combine, Map map)
+			: identity(identity), weight_fn(weight), combine_fn(combine), map_fn(map) {}
+
+		/**
+		 * Getter of neutral element
+		 * @return neutral element of combine operator
+		 */
+		Value get_identity() const {
+			return this->identity;
+		}
+
+		/**
+		 * Method returns weight of edge
+		 * @param edge_id id of edge
+		 * @param forward flag, if edge is forward
+		 * @return weight of edge
+		 */
+		Value weight(index_t edge_id, bool forward) const {
+			return this->weight_fn(edge_id, forward);
+		}
+
+		/**
+		 * Method combines weight of edge with sum of its successors
+		 * @param first value of earlier edge in euler tour
+		 * @param second value of later edge in euler tour
+		 * @return combined value
+		 */
+		Value combine(const Value &first, const Value &second) const {
+			return this->combine_fn(first, second);
+		}
+
+		/**
+		 * Method maps sums of edges of node to its value
+		 * @param down sum of suffix starting by forward edge into node
+		 * @param up sum of suffix starting by reverse edge from node
+		 * @return value of node
+		 */
+		result_t map(const Value &down, const Value &up) const {
+			return this->map_fn(down, up);
+		}
+};
+
+/**
+ * Function creates computation with deduced types of functors
+ * (see Tour_computation)
+ */
+template<typename Value, typename Weight, typename Combine, typename Map>
+Tour_computation<Value, Weight, Combine, Map> make_tour_computation(Value identity, Weight weight, Combine combine, Map map) {
+	return Tour_computation<Value, Weight, Combine, Map>(identity, weight, combine, map);
+}
+
+/**
+ * Structure of element of linked list sent between processes
+ * (value must be trivially copyable, it is sent as bytes)
+ */
+template<typename T>
+struct tour_elem_t {
+	T value;
+	index_t next;
+};
+
+/**
+ * Function sends values to process in pieces of at most MESSAGE_MAX_BYTES
+ * bytes (receiver must post same pieces by receive_pieces)
+ * @param values first value
+ * @param count number of values
+ * @param rank rank of receiving process
+ * @param requests requests of pieces are appended
+ */
+template<typename T>
+void send_pieces(const T *values, size_t count, int rank, vector<MPI_Request> &requests) {
+	const char *bytes = (const char *) values;
+	size_t total = count * sizeof(T);
+	for (size_t begin = 0; begin < total; begin += MESSAGE_MAX_BYTES) {
+		requests.push_back(MPI_REQUEST_NULL);
+		MPI_Isend(bytes + begin,min(total - begin, (size_t) MESSAGE_MAX_BYTES),MPI_BYTE,rank,VALUES_PIECE,
+			MPI_COMM_WORLD,&requests.back());
+	}
+}
+
+/**
+ * Function receives values sent by send_pieces
+ * @param values buffer for values
+ * @param count number of values
+ * @param rank rank of sending process
+ * @param requests requests of pieces are appended
+ */
+template<typename T>
+void receive_pieces(T *values, size_t count, int rank, vector<MPI_Request> &requests) {
+	char *bytes = (char *) values;
+	size_t total = count * sizeof(T);
+	for (size_t begin = 0; begin < total; begin += MESSAGE_MAX_BYTES) {
+		requests.push_back(MPI_REQUEST_NULL);
+		MPI_Irecv(bytes + begin,min(total - begin, (size_t) MESSAGE_MAX_BYTES),MPI_BYTE,rank,VALUES_PIECE,
+			MPI_COMM_WORLD,&requests.back());
+	}
+}
+
+/**
+ * Function exchanges buckets of values between all processes, values
+ * are sent as bytes (collective, every process must call it)
+ *
+ * counts are 64-bit, if all values of some process do not fit to
+ * one message (see MESSAGE_MAX_BYTES), every process sends its
+ * buckets in pieces by point-to-point messages instead of Alltoallv
+ * @param outbox values sent to every process
+ * @param recv_counts if given, set to number of values received from
+ * every process
+ * @return values received from all processes ordered by rank of sender
+ */
+template<typename T>
+vector<T> exchange_values(const vector<vector<T>> &outbox, vector<long long> *recv_counts = NULL) {
+	int size = outbox.size();
+	int rank;
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+	vector<long long> send_counts(size), counts(size);
+	long long send_total = 0;
+	for (int i = 0; i < size; i++) {
+		send_counts[i] = outbox[i].size();
+		send_total += send_counts[i];
+	}
+	MPI_Alltoall(send_counts.data(),1,MPI_LONG_LONG,counts.data(),1,MPI_LONG_LONG,MPI_COMM_WORLD);
+	vector<long long> recv_displs(size);
+	long long recv_total = 0;
+	for (int i = 0; i < size; i++) {
+		recv_displs[i] = recv_total;
+		recv_total += counts[i];
+	}
+	int fits = (send_total <= recv_total ? recv_total : send_total) * sizeof(T) <= MESSAGE_MAX_BYTES;
+	MPI_Allreduce(MPI_IN_PLACE,&fits,1,MPI_INT,MPI_MIN,MPI_COMM_WORLD);
+	if (recv_counts != NULL) {
+		*recv_counts = counts;
+	}
+
+	vector<T> recv_values(recv_total);
+	if (!fits) {
+		vector<MPI_Request> requests;
+		for (int i = 0; i < size; i++) {
+			if (i == rank) {
+				copy(outbox[i].begin(), outbox[i].end(), recv_values.begin() + recv_displs[i]);
+				continue;
+			}
+			receive_pieces(recv_values.data() + recv_displs[i], counts[i], i, requests);
+			send_pieces(outbox[i].data(), outbox[i].size(), i, requests);
+		}
+		MPI_Waitall(requests.size(),requests.data(),MPI_STATUSES_IGNORE);
+		return recv_values;
+	}
+
+	// counts are in values, not in bytes (type of one value)
+	vector<int> int_send_counts(size), int_counts(size), send_displs(size), int_recv_displs(size);
+	vector<T> send_values;
+	send_values.reserve(send_total);
+	for (int i = 0; i < size; i++) {
+		int_send_counts[i] = send_counts[i];
+		int_counts[i] = counts[i];
+		send_displs[i] = send_values.size();
+		int_recv_displs[i] = recv_displs[i];
+		send_values.insert(send_values.end(), outbox[i].begin(), outbox[i].end());
+	}
+	MPI_Datatype type;
+	MPI_Type_contiguous(sizeof(T),MPI_BYTE,&type);
+	MPI_Type_commit(&type);
+	MPI_Alltoallv(send_values.data(),int_send_counts.data(),send_displs.data(),type,
+		recv_values.data(),int_counts.data(),int_recv_displs.data(),type,MPI_COMM_WORLD);
+	MPI_Type_free(&type);
+	return recv_values;
+}
+
+/**
+ * Function gathers values of all processes to main process, values
+ * are sent as bytes (collective, every process must call it)
+ *
+ * counts are 64-bit, if gathered values do not fit to one message
+ * (see MESSAGE_MAX_BYTES), they are sent in pieces instead of Gatherv
+ * @param values values of calling process
+ * @param rank rank of calling process
+ * @return values of all processes ordered by rank on main process
+ * (empty on others)
+ */
+template<typename T>
+vector<T> gather_values(const vector<T> &values, int rank) {
+	int size;
+	MPI_Comm_size(MPI_COMM_WORLD, &size);
+	long long values_num = values.size();
+	vector<long long> recv_counts(size), recv_displs(size);
+	MPI_Gather(&values_num,1,MPI_LONG_LONG,recv_counts.data(),1,MPI_LONG_LONG,PROC_MAIN,MPI_COMM_WORLD);
+	long long recv_total = 0;
+	for (int i = 0; i < size; i++) {
+		recv_displs[i] = recv_total;
+		recv_total += recv_counts[i];
+	}
+	int fits = recv_total * sizeof(T) <= MESSAGE_MAX_BYTES;
+	MPI_Bcast(&fits,1,MPI_INT,PROC_MAIN,MPI_COMM_WORLD);
+	vector<T> all_values(rank == PROC_MAIN ? recv_total : 0);
+	if (!fits) {
+		vector<MPI_Request> requests;
+		if (rank != PROC_MAIN) {
+			send_pieces(values.data(), values.size(), PROC_MAIN, requests);
+		} else {
+			for (int i = 0; i < size; i++) {
+				if (i == PROC_MAIN) {
+					copy(values.begin(), values.end(), all_values.begin() + recv_displs[i]);
+				} else {
+					receive_pieces(all_values.data() + recv_displs[i], recv_counts[i], i, requests);
+				}
+			}
+		}
+		MPI_Waitall(requests.size(),requests.data(),MPI_STATUSES_IGNORE);
+		return all_values;
+	}
+
+	vector<int> int_counts(size), int_displs(size);
+	for (int i = 0; i < size; i++) {
+		int_counts[i] = recv_counts[i];
+		int_displs[i] = recv_displs[i];
+	}
+	MPI_Datatype type;
+	MPI_Type_contiguous(sizeof(T),MPI_BYTE,&type);
+	MPI_Type_commit(&type);
+	MPI_Gatherv(values.data(),values_num,type,all_values.data(),
+		int_counts.data(),int_displs.data(),type,PROC_MAIN,MPI_COMM_WORLD);
+	MPI_Type_free(&type);
+	return all_values;
+}
+
+/**
+ * Function broadcasts values from main process in pieces of at most
+ * MESSAGE_MAX_BYTES bytes (collective, every process must call it)
+ * @param values buffer of values (filled on processes except main)
+ * @param count number of values (same on every process)
+ */
+template<typename T>
+void broadcast_values(T *values, size_t count) {
+	char *bytes = (char *) values;
+	size_t total = count * sizeof(T);
+	for (size_t begin = 0; begin < total; begin += MESSAGE_MAX_BYTES) {
+		MPI_Bcast(bytes + begin,min(total - begin, (size_t) MESSAGE_MAX_BYTES),MPI_BYTE,PROC_MAIN,MPI_COMM_WORLD);
+	}
+}
+
+/**
+ * Function reads values of edges stored in blocks of any process
+ * (collective, every process must call it)
+ * @param ids ids of wanted edges
+ * @param local values of edges in block of calling process
+ * @param block distribution of edges to processes
+ * @param rank rank of calling process
+ * @return values of wanted edges in order of ids
+ */
+template<typename T>
+vector<T> block_fetch(const vector<index_t> &ids, const vector<T> &local, Edge_block block, int rank) {
+	int size;
+	MPI_Comm_size(MPI_COMM_WORLD, &size);
+	index_t first = block.first(rank);
+
+	// collect ids stored in blocks of other processes
+	vector<vector<index_t>> wanted(size);
+	for (size_t i = 0; i < ids.size(); i++) {
+		int owner = block.owner(ids[i]);
+		if (owner != rank) {
+			wanted[owner].push_back(ids[i]);
+		}
+	}
+
+	// answer every request in order of ids received from its process
+	vector<long long> recv_counts;
+	vector<index_t> recv_ids = exchange_values(wanted, &recv_counts);
+	vector<vector<T>> answers(size);
+	size_t j = 0;
+	for (int i = 0; i < size; i++) {
+		answers[i].reserve(recv_counts[i]);
+		for (long long k = 0; k < recv_counts[i]; k++, j++) {
+			answers[i].push_back(local[recv_ids[j] - first]);
+		}
+	}
+	vector<T> values = exchange_values(answers);
+
+	// remote values are read in same order, in which they were requested
+	vector<size_t> value_positions(size, 0);
+	for (int i = 1; i < size; i++) {
+		value_positions[i] = value_positions[i - 1] + wanted[i - 1].size();
+	}
+	vector<T> result(ids.size());
+	for (size_t i = 0; i < ids.size(); i++) {
+		int owner = block.owner(ids[i]);
+		if (owner == rank) {
+			result[i] = local[ids[i] - first];
+		} else {
+			result[i] = values[value_positions[owner]++];
+		}
+	}
+	return result;
+}
+
+/**
+ * Function counts suffix sum by pointer jumping with edges distributed
+ * in blocks, sums are combined by given operator
+ * @param value values of edges in block, replaced by suffix sums
+ * @param euler_next successors of edges in block (ending edge points
+ * to itself), replaced by ids of edges themselves
+ * @param block distribution of edges to processes
+ * @param rank rank of calling process
+ * @param combine associative operator
+ */
+template<typename T, typename Combine>
+void block_suffix_scan(vector<T> &value, vector<index_t> &euler_next, Edge_block block, int rank, Combine combine) {
+	index_t first = block.first(rank);
+	index_t count = block.count(rank);
+
+	// rounds run until every edge is finished, so their number is given
+	// by length of list, not by number of edges
+	while (true) {
+		// values from previous round (to avoid RAW conflict between
+		// local edges and between requests of other processes)
+		vector<tour_elem_t<T>> old(count);
+		vector<index_t> wanted;
+		for (index_t i = 0; i < count; i++) {
+			old[i].value = value[i];
+			old[i].next = euler_next[i];
+			if (euler_next[i] != first + i) {
+				wanted.push_back(euler_next[i]);
+			}
+		}
+		int active = !wanted.empty();
+		MPI_Allreduce(MPI_IN_PLACE,&active,1,MPI_INT,MPI_MAX,MPI_COMM_WORLD);
+		if (!active) {
+			break;
+		}
+		Profile::round();
+		vector<tour_elem_t<T>> successors = block_fetch(wanted, old, block, rank);
+
+		// update values and successors, edge reading finished successor
+		// (pointing to itself) is finished too, so no edge is read
+		// by more than one edge in a round
+		for (index_t i = 0, j = 0; i < count; i++) {
+			if (old[i].next == first + i) {
+				continue;
+			}
+			value[i] = combine(old[i].value, successors[j].value);
+			euler_next[i] = successors[j].next == old[i].next ? first + i : successors[j].next;
+			j++;
+		}
+	}
+}
+
+/**
+ * Function runs computation over euler tour with edges distributed in blocks
+ * @param computation weights, operator and mapping (see Tour_computation)
+ * @param euler_next successors of edges in block (ending edge points to itself)
+ * @param forward flags of edges in block, true for forward edges
+ * @param block distribution of edges to processes
+ * @param rank rank of calling process
+ * @return pairs (forward edge id, value of node at its end) for forward edges in block
+ */
+template<typename Computation>
+vector<pair<index_t, typename Computation::result_t>> block_compute(const Computation &computation,
+		vector<index_t> euler_next, const vector<bool> &forward, Edge_block block, int rank) {
+	typedef typename Computation::value_t value_t;
+	index_t first = block.first(rank);
+	index_t count = block.count(rank);
+
+	/**** SET WEIGHTS ****/
+	Profile::phase("SET WEIGHTS");
+	vector<value_t> value(count);
+	for (index_t i = 0; i < count; i++) {
+		if (euler_next[i] == first + i) {
+			value[i] = computation.get_identity();
+		} else {
+			value[i] = computation.weight(first + i, forward[i]);
+		}
+	}
+
+	/**** SUM OF SUFFIX ****/
+	Profile::phase("SUM OF SUFFIX");
+	block_suffix_scan(value, euler_next, block, rank,
+		[&computation](const value_t &a, const value_t &b) { return computation.combine(a, b); });
+
+	/**** MAP TO NODES ****/
+	Profile::phase("MAP TO NODES");
+	// reverse edge is stored next to forward edge, but it may be in next block
+	vector<index_t> reverse_ids;
+	for (index_t i = 0; i < count; i++) {
+		if (forward[i]) {
+			reverse_ids.push_back(utility::heap_reverse(first + i));
+		}
+	}
+	vector<value_t> up = block_fetch(reverse_ids, value, block, rank);
+	vector<pair<index_t, typename Computation::result_t>> result;
+	for (index_t i = 0, j = 0; i < count; i++) {
+		if (forward[i]) {
+			result.push_back(make_pair(first + i, computation.map(value[i], up[j++])));
+		}
+	}
+	return result;
+}
+
+typedef Tour_vector<index_t, NUMBERS_WEIGHTS> numbers_weight_t;
+typedef Tour_vector<index_t, NUMBERS_COUNT> numbers_t;
+
+/**
+ * Functor assigns weights of predefined tree numbers, first component
+ * counts forward edges (1 for forward, 0 for reverse edge), second
+ * counts depth (1 for forward, -1 for reverse edge)
+ */
+struct Tree_numbers_weight {
+	numbers_weight_t operator()(index_t, bool forward) const {
+		numbers_weight_t weight;
+		weight[0] = forward ? 1 : 0;
+		weight[1] = forward ? 1 : -1;
+		return weight;
+	}
+};
+
+/**
+ * Functor maps sums to predefined tree numbers of node, components
+ * are ordered as in tree_number_index
+ */
+struct Tree_numbers_map {
+	index_t node_count;
+
+	numbers_t operator()(const numbers_weight_t &down, const numbers_weight_t &up) const {
+		numbers_t numbers;
+		// forward edges after node in preorder are counted by down sum
+		index_t pre = this->node_count - down[0];
+		// ending edge is not counted, so whole tour sums to 1
+		index_t depth = 2 - down[1];
+		// forward edges between edges of node belong to its subtree
+		index_t size = down[0] - up[0];
+		numbers[0] = pre;
+		numbers[1] = pre + size - 1 - depth;
+		numbers[2] = depth;
+		numbers[3] = size;
+		numbers[4] = size - 1;
+		return numbers;
+	}
+};
+
+/**
+ * Function creates computation of all predefined tree numbers in one sweep
+ * @param node_count number of nodes in tree
+ * @return computation of preorder, postorder, depth, subtree size and
+ * number of descendants
+ */
+inline Tour_computation<numbers_weight_t, Tree_numbers_weight, plus<numbers_weight_t>, Tree_numbers_map> tree_numbers_computation(index_t node_count) {
+	Tree_numbers_map map;
+	map.node_count = node_count;
+	return make_tour_computation(numbers_weight_t(0), Tree_numbers_weight(), plus<numbers_weight_t>(), map);
+}
+
+/**
+ * Function returns index of predefined tree number
+ * @param name name of tree number
+ * @return index of tree number in numbers_t
+ */
+inline int tree_number_index(string name) {
+	const char *names[NUMBERS_COUNT] = {NUMBER_PRE, NUMBER_POST, NUMBER_DEPTH, NUMBER_SIZE, NUMBER_DESC};
+	for (int i = 0; i < NUMBERS_COUNT; i++) {
+		if (name == names[i]) {
+			return i;
+		}
+	}
+	throw "unknown tree number, use pre, post, depth, size or desc";
+}
+
+/**
+ * Function returns indexes of predefined tree numbers in list
+ * @param list names of tree numbers separated by NUMBERS_SEPARATOR
+ * @return indexes of tree numbers in order of list (throws on unknown
+ * or empty name, so empty list is invalid too)
+ */
+inline vector<int> tree_number_indexes(string list) {
+	vector<int> indexes;
+	size_t start = 0;
+	while (start <= list.size()) {
+		size_t end = list.find(NUMBERS_SEPARATOR, start);
+		if (end == string::npos) {
+			end = list.size();
+		}
+		indexes.push_back(tree_number_index(list.substr(start, end - start)));
+		start = end + 1;
+	}
+	return indexes;
+}
+
+/**
+ * Function returns predefined tree numbers of root
+ * @param node_count number of nodes in tree
+ * @return numbers of root (root is not end of any edge)
+ */
+inline numbers_t root_numbers(index_t node_count) {
+	numbers_t numbers;
+	numbers[0] = 0;
+	numbers[1] = node_count - 1;
+	numbers[2] = 0;
+	numbers[3] = node_count;
+	numbers[4] = node_count - 1;
+	return numbers;
+}
+
+/**
+ * Function counts all predefined tree numbers with edges distributed
+ * in blocks and gathers them to main process (collective)
+ * @param options settings given on command line
+ * @param tree input tree
+ * @param rank rank of calling process
+ * @param size total number of processes
+ * @return numbers of every node on main process (empty on others)
+ */
+vector<numbers_t> block_numbers(Options options, const Tree &tree, int rank, int size);
+
+#endif
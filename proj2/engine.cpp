@@ -0,0 +1,224 @@
+/**
+ * @file engine.cpp
+ * @author Jiri Kristof <xkrist22@stud.fit.vutbr.cz>
+ * @brief File contains sequential engine and selection of engine of project "preorder tree"
+ */
+
+#include <stdlib.h>
+#include <fstream>
+#include "engine.h"
+
+using namespace std;
+
+// results of measured work are stored here, so it is not optimized out
+static volatile index_t calibration_sink;
+
+Cost_model::Cost_model() {
+	this->seq_node = 1e-8;
+	this->item = 5e-9;
+	this->thread_startup = 1e-4;
+	this->thread_round = 1e-5;
+	this->mpi_round = 1e-5;
+}
+
+void Cost_model::calibrate(int threads, int rank) {
+	// latency of collective round is measured by every process
+	int value = rank, recieved;
+	MPI_Barrier(MPI_COMM_WORLD);
+	double start = MPI_Wtime();
+	for (int i = 0; i < CALIBRATION_ROUNDS; i++) {
+		MPI_Allreduce(&value,&recieved,1,MPI_INT,MPI_SUM,MPI_COMM_WORLD);
+	}
+	double round = (MPI_Wtime() - start) / CALIBRATION_ROUNDS;
+	MPI_Allreduce(&round,&this->mpi_round,1,MPI_DOUBLE,MPI_MAX,MPI_COMM_WORLD);
+	if (rank != PROC_MAIN) {
+		return;
+	}
+
+	// sequential DFS and one round of pointer jumping over heap
+	// (DFS is measured twice, first run only warms up caches)
+	Tree tree = Tree(string(CALIBRATION_NODES, 'a'));
+	vector<index_t> order = sequential_order(tree);
+	start = MPI_Wtime();
+	order = sequential_order(tree);
+	this->seq_node = (MPI_Wtime() - start) / CALIBRATION_NODES;
+	calibration_sink = order.back();
+
+	index_t edge_count = 2 * (CALIBRATION_NODES - 1);
+	vector<index_t> weight(edge_count + 1, 1), next(edge_count + 1);
+	for (index_t i = 1; i <= edge_count; i++) {
+		next[i] = utility::heap_euler_tour(i, CALIBRATION_NODES);
+	}
+	vector<index_t> weight_next(weight), next_next(next);
+	start = MPI_Wtime();
+	for (index_t i = 1; i <= edge_count; i++) {
+		weight_next[i] = weight[i] + weight[next[i]];
+		next_next[i] = next[next[i]];
+	}
+	this->item = (MPI_Wtime() - start) / edge_count;
+	index_t sum = 0;
+	for (index_t i = 1; i <= edge_count; i++) {
+		sum += weight_next[i] + next_next[i];
+	}
+	calibration_sink = sum;
+
+	// startup of pool and barrier between rounds
+	start = MPI_Wtime();
+	{
+		Thread_pool pool = Thread_pool(threads);
+		this->thread_startup = MPI_Wtime() - start;
+		start = MPI_Wtime();
+		pool.run([&](int) {
+			for (int i = 0; i < CALIBRATION_ROUNDS; i++) {
+				pool.sync();
+			}
+		});
+		this->thread_round = (MPI_Wtime() - start) / CALIBRATION_ROUNDS;
+		start = MPI_Wtime();
+	}
+	this->thread_startup += MPI_Wtime() - start;
+}
+
+bool Cost_model::load(string file_name) {
+	ifstream file(file_name);
+	if (!file.is_open()) {
+		return false;
+	}
+	string key;
+	double value;
+	int loaded = 0;
+	while (file >> key >> value) {
+		if (key == "seq_node") {
+			this->seq_node = value;
+		} else if (key == "item") {
+			this->item = value;
+		} else if (key == "thread_startup") {
+			this->thread_startup = value;
+		} else if (key == "thread_round") {
+			this->thread_round = value;
+		} else if (key == "mpi_round") {
+			this->mpi_round = value;
+		} else {
+			continue;
+		}
+		loaded++;
+	}
+	return loaded == 5;
+}
+
+bool Cost_model::save(string file_name) {
+	ofstream file(file_name);
+	if (!file.is_open()) {
+		return false;
+	}
+	file << "seq_node " << this->seq_node << endl;
+	file << "item " << this->item << endl;
+	file << "thread_startup " << this->thread_startup << endl;
+	file << "thread_round " << this->thread_round << endl;
+	file << "mpi_round " << this->mpi_round << endl;
+	return true;
+}
+
+double Cost_model::estimate(int engine, index_t node_count, int workers) {
+	index_t edge_count = 2 * (node_count - 1);
+	int rounds = utility::pointer_jumping_rounds(edge_count) + 1;
+	double work = this->item * edge_count / workers;
+	switch (engine) {
+		case ENGINE_SEQUENTIAL:
+			return this->seq_node * node_count;
+		case ENGINE_THREADS:
+			return this->thread_startup + rounds * (this->thread_round + work);
+		default:
+			// few more collectives are needed for input and result
+			return (rounds + 4) * this->mpi_round + rounds * work;
+	}
+}
+
+int Cost_model::choose(index_t node_count, int threads, int size) {
+	int engine = ENGINE_SEQUENTIAL;
+	double best = this->estimate(ENGINE_SEQUENTIAL, node_count, 1);
+	if (threads > 1 && this->estimate(ENGINE_THREADS, node_count, threads) < best) {
+		engine = ENGINE_THREADS;
+		best = this->estimate(ENGINE_THREADS, node_count, threads);
+	}
+	if (size > 1 && this->estimate(ENGINE_DISTRIBUTED, node_count, size) < best) {
+		engine = ENGINE_DISTRIBUTED;
+	}
+	return engine;
+}
+
+vector<index_t> sequential_order(const Tree &tree) {
+	index_t node_count = tree.get_node_count();
+	index_t root = tree.get_root();
+
+	// children stored one after another in order of their ids
+	vector<index_t> first_child(node_count + 1, 0);
+	for (index_t node = 0; node < node_count; node++) {
+		if (node != root) {
+			first_child[tree.get_parent(node) + 1]++;
+		}
+	}
+	for (index_t node = 0; node < node_count; node++) {
+		first_child[node + 1] += first_child[node];
+	}
+	vector<index_t> children(node_count);
+	vector<index_t> position(first_child.begin(), first_child.end() - 1);
+	for (index_t node = 0; node < node_count; node++) {
+		if (node != root) {
+			children[position[tree.get_parent(node)]++] = node;
+		}
+	}
+
+	// children are pushed in reverse order, so first child is visited first
+	vector<index_t> order;
+	order.reserve(node_count);
+	vector<index_t> stack(1, root);
+	while (!stack.empty()) {
+		index_t node = stack.back();
+		stack.pop_back();
+		order.push_back(node);
+		for (index_t i = first_child[node + 1] - 1; i >= first_child[node]; i--) {
+			stack.push_back(children[i]);
+		}
+	}
+	return order;
+}
+
+void sequential_preorder(const Tree &tree) {
+	tree.print(sequential_order(tree));
+}
+
+string cost_cache_file(int size) {
+	const char *cache = getenv("XDG_CACHE_HOME");
+	const char *home = getenv("HOME");
+	if (cache != NULL && cache[0] != '\0') {
+		return string(cache) + "/" + COST_CACHE_NAME + to_string(size);
+	} else if (home != NULL && home[0] != '\0') {
+		return string(home) + "/.cache/" + COST_CACHE_NAME + to_string(size);
+	}
+	return "";
+}
+
+int select_engine(Options options, index_t node_count, int rank, int size) {
+	int threads = options.threads > 0 ? options.threads : max(1, (int) thread::hardware_concurrency());
+	Cost_model model;
+
+	// costs are measured only if they cannot be loaded and tree is big
+	// enough to pay for measuring (node count is same on every process)
+	string profile = options.cost_profile.empty() ? cost_cache_file(size) : options.cost_profile;
+	if (node_count >= CALIBRATION_MIN_NODES || !options.cost_profile.empty()) {
+		int loaded = rank == PROC_MAIN && !profile.empty() && model.load(profile);
+		MPI_Bcast(&loaded,1,MPI_INT,PROC_MAIN,MPI_COMM_WORLD);
+		if (!loaded) {
+			model.calibrate(threads, rank);
+			// missing cache directory is not an error
+			if (rank == PROC_MAIN && !profile.empty() && !model.save(profile) && !options.cost_profile.empty()) {
+				fprintf(stderr, "cannot write cost profile\n");
+			}
+		}
+	}
+
+	int engine = model.choose(node_count, threads, size);
+	MPI_Bcast(&engine,1,MPI_INT,PROC_MAIN,MPI_COMM_WORLD);
+	return engine;
+}
@@ -0,0 +1,128 @@
+/**
+ * @file engine.h
+ * @author Jiri Kristof, <xkrist22@stud.fit.vutbr.cz>
+ * @brief header file of sequential engine and selection of engine of project "preorder tree"
+ */
+
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#include "pro.h"
+#include "threads.h"
+
+// engines, which can be chosen by cost model
+#define ENGINE_SEQUENTIAL 0
+#define ENGINE_THREADS 1
+#define ENGINE_DISTRIBUTED 2
+
+// size of heap used to measure costs
+#define CALIBRATION_NODES 16384
+
+// number of collective rounds used to measure latency of round
+#define CALIBRATION_ROUNDS 8
+
+// smaller trees are ranked faster than costs are measured, so engine
+// is chosen by default costs
+#define CALIBRATION_MIN_NODES CALIBRATION_NODES
+
+// file of measured costs used without -k (in XDG_CACHE_HOME or
+// HOME/.cache, number of processes is appended)
+#define COST_CACHE_NAME "pro-costs-"
+
+/**
+ * Class implements cost model of engines
+ *
+ * sequential DFS costs seq_node per node, pointer jumping costs item
+ * per edge and round divided by number of workers, threads pay startup
+ * of pool and barrier for every round, processes pay latency of
+ * collective round (all costs are in seconds)
+ */
+class Cost_model {
+	private:
+		double seq_node;
+		double item;
+		double thread_startup;
+		double thread_round;
+		double mpi_round;
+	public:
+		/**
+		 * Constructor of model with default costs (used before calibration)
+		 */
+		Cost_model();
+
+		/**
+		 * Method measures costs on small heap (collective, latency of
+		 * round is measured by every process, rest by main process)
+		 * @param threads number of threads available for shared memory engine
+		 * @param rank rank of calling process
+		 */
+		void calibrate(int threads, int rank);
+
+		/**
+		 * Method loads costs from profile file
+		 * @param file_name name of profile file
+		 * @return true, if all costs were loaded
+		 */
+		bool load(string file_name);
+
+		/**
+		 * Method stores costs to profile file
+		 * @param file_name name of profile file
+		 * @return true, if file was written
+		 */
+		bool save(string file_name);
+
+		/**
+		 * Method estimates time of engine
+		 * @param engine one of ENGINE_* values
+		 * @param node_count number of nodes in tree
+		 * @param workers number of threads or processes
+		 * @return estimated time in seconds
+		 */
+		double estimate(int engine, index_t node_count, int workers);
+
+		/**
+		 * Method chooses fastest engine
+		 * @param node_count number of nodes in tree
+		 * @param threads number of threads available for shared memory engine
+		 * @param size number of processes
+		 * @return one of ENGINE_* values
+		 */
+		int choose(index_t node_count, int threads, int size);
+};
+
+/**
+ * Function computes preorder by sequential DFS (children are visited
+ * in order of their ids, so order is same as in parallel engines)
+ * @param tree input tree (parent array must be known)
+ * @return ids of nodes in preorder
+ */
+vector<index_t> sequential_order(const Tree &tree);
+
+/**
+ * Function computes and prints preorder by sequential DFS
+ * @param tree input tree
+ */
+void sequential_preorder(const Tree &tree);
+
+/**
+ * Function returns default profile file of cost model (measured costs
+ * are cached there, so they are not measured on every run)
+ * @param size total number of processes (latency of round depends on it)
+ * @return name of file, empty if no cache directory is known
+ */
+string cost_cache_file(int size);
+
+/**
+ * Function selects engine by cost model (collective), costs are loaded
+ * from profile file (-k or cache file) or measured and then stored to
+ * it, small trees use default costs without measuring
+ * @param options settings given on command line
+ * @param node_count number of nodes in tree
+ * @param rank rank of calling process
+ * @param size total number of processes
+ * @return one of ENGINE_* values (same on every process)
+ */
+int select_engine(Options options, index_t node_count, int rank, int size);
+
+#endif
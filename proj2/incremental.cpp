@@ -0,0 +1,270 @@
+/**
+ * @file incremental.cpp
+ * @author Jiri Kristof <xkrist22@stud.fit.vutbr.cz>
+ * @brief File contains incremental preorder of project "preorder tree"
+ */
+
+#include "incremental.h"
+
+using namespace std;
+
+Incremental_preorder::Incremental_preorder(const Tree &tree) {
+	this->root = tree.get_root();
+	this->top = NO_ITEM;
+	this->node_count = tree.get_node_count();
+	// priorities are pseudorandom, but same for every run
+	this->generator = mt19937(this->node_count);
+	this->parent.resize(this->node_count);
+	this->children.assign(this->node_count, 0);
+	for (index_t node = 0; node < this->node_count; node++) {
+		this->parent[node] = tree.get_parent(node);
+		if (node != this->root) {
+			this->children[this->parent[node]]++;
+		}
+	}
+	for (index_t item = 0; item < 2 * this->node_count; item++) {
+		this->create(item);
+	}
+	if (this->node_count == 1) {
+		return;
+	}
+
+	// treap is built from tour by stack of its right spine (items on
+	// stack have decreasing priority), so whole build is linear
+	Edge_store edges = Edge_store(tree);
+	vector<index_t> spine;
+	for (index_t edge = edges.get_head(); ; edge = edges.get_euler_next(edge)) {
+		index_t item = edges.is_forward(edge) ? 2 * edges.get_target(edge) : 2 * edges.get_source(edge) + 1;
+		index_t last = NO_ITEM;
+		while (!spine.empty() && this->priority[spine.back()] < this->priority[item]) {
+			last = spine.back();
+			spine.pop_back();
+		}
+		this->left[item] = last;
+		if (last != NO_ITEM) {
+			this->up[last] = item;
+		}
+		if (!spine.empty()) {
+			this->right[spine.back()] = item;
+			this->up[item] = spine.back();
+		}
+		spine.push_back(item);
+		if (edge == edges.get_ending_edge()) {
+			break;
+		}
+	}
+	this->top = spine.front();
+
+	// sizes are counted from leaves of treap (reverse of DFS order)
+	vector<index_t> visited;
+	vector<index_t> stack(1, this->top);
+	while (!stack.empty()) {
+		index_t item = stack.back();
+		stack.pop_back();
+		visited.push_back(item);
+		if (this->left[item] != NO_ITEM) {
+			stack.push_back(this->left[item]);
+		}
+		if (this->right[item] != NO_ITEM) {
+			stack.push_back(this->right[item]);
+		}
+	}
+	for (index_t i = visited.size() - 1; i >= 0; i--) {
+		this->update(visited[i]);
+	}
+}
+
+void Incremental_preorder::create(index_t item) {
+	if (item >= this->left.size()) {
+		this->left.resize(item + 1, NO_ITEM);
+		this->right.resize(item + 1, NO_ITEM);
+		this->up.resize(item + 1, NO_ITEM);
+		this->priority.resize(item + 1, 0);
+		this->items.resize(item + 1, 0);
+		this->forwards.resize(item + 1, 0);
+	}
+	this->left[item] = NO_ITEM;
+	this->right[item] = NO_ITEM;
+	this->up[item] = NO_ITEM;
+	this->priority[item] = this->generator();
+	this->items[item] = 1;
+	this->forwards[item] = item % 2 == 0;
+}
+
+index_t Incremental_preorder::count(index_t item, bool forward) {
+	if (item == NO_ITEM) {
+		return 0;
+	}
+	return forward ? this->forwards[item] : this->items[item];
+}
+
+void Incremental_preorder::update(index_t item) {
+	this->items[item] = this->count(this->left[item], false) + 1 + this->count(this->right[item], false);
+	this->forwards[item] = this->count(this->left[item], true) + (item % 2 == 0) + this->count(this->right[item], true);
+}
+
+index_t Incremental_preorder::merge(index_t a, index_t b) {
+	if (a == NO_ITEM || b == NO_ITEM) {
+		return a == NO_ITEM ? b : a;
+	}
+	// item with higher priority becomes root, returned root has no parent
+	if (this->priority[a] > this->priority[b]) {
+		this->right[a] = this->merge(this->right[a], b);
+		this->up[this->right[a]] = a;
+		this->update(a);
+		return a;
+	}
+	this->left[b] = this->merge(a, this->left[b]);
+	this->up[this->left[b]] = b;
+	this->update(b);
+	return b;
+}
+
+void Incremental_preorder::split(index_t item, index_t count, index_t &a, index_t &b) {
+	if (item == NO_ITEM) {
+		a = NO_ITEM;
+		b = NO_ITEM;
+		return;
+	}
+	// roots of both parts have no parent
+	index_t left_count = this->count(this->left[item], false);
+	if (left_count >= count) {
+		index_t rest;
+		this->split(this->left[item], count, a, rest);
+		this->left[item] = rest;
+		if (rest != NO_ITEM) {
+			this->up[rest] = item;
+		}
+		b = item;
+	} else {
+		index_t rest;
+		this->split(this->right[item], count - left_count - 1, rest, b);
+		this->right[item] = rest;
+		if (rest != NO_ITEM) {
+			this->up[rest] = item;
+		}
+		a = item;
+	}
+	this->up[item] = NO_ITEM;
+	this->update(item);
+}
+
+index_t Incremental_preorder::position(index_t item, bool forward) {
+	// items in left subtrees on path to root are before item
+	index_t position = this->count(this->left[item], forward) + (forward && item % 2 == 0);
+	for (index_t current = item; this->up[current] != NO_ITEM; current = this->up[current]) {
+		index_t parent = this->up[current];
+		if (this->right[parent] == current) {
+			position += this->count(this->left[parent], forward) + (!forward || parent % 2 == 0);
+		}
+	}
+	return position;
+}
+
+bool Incremental_preorder::exists(index_t node) {
+	return node >= 0 && node < this->parent.size() && this->parent[node] != DELETED_NODE;
+}
+
+index_t Incremental_preorder::insert_leaf(index_t node) {
+	if (!this->exists(node)) {
+		throw "Unknown node in update";
+	}
+	index_t leaf = this->parent.size();
+	this->parent.push_back(node);
+	this->children.push_back(0);
+	this->children[node]++;
+	this->node_count++;
+	this->create(2 * leaf);
+	this->create(2 * leaf + 1);
+	index_t pair = this->merge(2 * leaf, 2 * leaf + 1);
+
+	// new leaf is last child, so its edges go before reverse edge of parent
+	if (node == this->root) {
+		this->top = this->merge(this->top, pair);
+	} else {
+		index_t before, after;
+		this->split(this->top, this->position(2 * node + 1, false), before, after);
+		this->top = this->merge(this->merge(before, pair), after);
+	}
+	return leaf;
+}
+
+void Incremental_preorder::delete_leaf(index_t node) {
+	if (!this->exists(node)) {
+		throw "Unknown node in update";
+	}
+	if (node == this->root || this->children[node] != 0) {
+		throw "Deleted node is not a leaf";
+	}
+	// edges of leaf follow each other in tour
+	index_t before, pair, after;
+	this->split(this->top, this->position(2 * node, false), before, after);
+	this->split(after, 2, pair, after);
+	this->top = this->merge(before, after);
+	this->children[this->parent[node]]--;
+	this->parent[node] = DELETED_NODE;
+	this->node_count--;
+}
+
+index_t Incremental_preorder::preorder(index_t node) {
+	if (!this->exists(node)) {
+		throw "Unknown node in update";
+	}
+	return node == this->root ? 0 : this->position(2 * node, true);
+}
+
+vector<index_t> Incremental_preorder::order() {
+	// in-order walk of treap, forward edges give nodes after root
+	vector<index_t> result(1, this->root);
+	result.reserve(this->node_count);
+	vector<index_t> stack;
+	index_t item = this->top;
+	while (item != NO_ITEM || !stack.empty()) {
+		while (item != NO_ITEM) {
+			stack.push_back(item);
+			item = this->left[item];
+		}
+		item = stack.back();
+		stack.pop_back();
+		if (item % 2 == 0) {
+			result.push_back(item / 2);
+		}
+		item = this->right[item];
+	}
+	return result;
+}
+
+void incremental_preorder(const Tree &tree, istream &input) {
+	Incremental_preorder state = Incremental_preorder(tree);
+	tree.print(state.order());
+	fflush(stdout);
+
+	// every answer is flushed, so commands can come from pipe
+	string command;
+	while (input >> command) {
+		if (command.length() != 1) {
+			throw "Invalid update command";
+		}
+		index_t node = 0;
+		if (command[0] != UPDATE_PRINT && !(input >> node)) {
+			throw "Missing node in update";
+		}
+		switch (command[0]) {
+			case UPDATE_INSERT:
+				printf("%lld\n", (long long) state.insert_leaf(node));
+				break;
+			case UPDATE_DELETE:
+				state.delete_leaf(node);
+				break;
+			case UPDATE_QUERY:
+				printf("%s %lld\n", tree.label(node).c_str(), (long long) state.preorder(node));
+				break;
+			case UPDATE_PRINT:
+				tree.print(state.order());
+				break;
+			default:
+				throw "Invalid update command";
+		}
+		fflush(stdout);
+	}
+}
@@ -0,0 +1,156 @@
+/**
+ * @file incremental.h
+ * @author Jiri Kristof, <xkrist22@stud.fit.vutbr.cz>
+ * @brief header file of incremental preorder of project "preorder tree"
+ *
+ * euler tour is kept in balanced search tree (treap ordered by position
+ * in tour), every item counts edges and forward edges in its subtree,
+ * so position of forward edge (aka preorder of its end node) is found
+ * by walk to root of treap and leaf edit splices two edges into tour
+ * by split and merge, both in expected logarithmic time
+ */
+
+#ifndef INCREMENTAL_H
+#define INCREMENTAL_H
+
+#include <istream>
+#include <random>
+#include "pro.h"
+
+// commands of update file
+#define UPDATE_INSERT '+'
+#define UPDATE_DELETE '-'
+#define UPDATE_QUERY '?'
+#define UPDATE_PRINT 'p'
+
+// item missing in treap
+#define NO_ITEM -1
+
+// parent of deleted node
+#define DELETED_NODE -2
+
+/**
+ * Class keeps preorder of tree changed by leaf insertions and deletions
+ *
+ * items of treap are edges of tour, forward edge into node v is item
+ * 2v and reverse edge from v is item 2v + 1 (root has no items), new
+ * leaf gets next unused id, so it is last child of its parent (children
+ * are ordered by ids as in other engines) and its edges are spliced
+ * just before reverse edge of parent (at the end of tour for root),
+ * ids of deleted nodes are not reused
+ */
+class Incremental_preorder {
+	private:
+		index_t root;
+		index_t top;
+		index_t node_count;
+		vector<index_t> parent;
+		vector<index_t> children;
+		vector<index_t> left;
+		vector<index_t> right;
+		vector<index_t> up;
+		vector<unsigned int> priority;
+		vector<index_t> items;
+		vector<index_t> forwards;
+		mt19937 generator;
+
+		/**
+		 * Method creates item of treap (edge of tour)
+		 * @param item id of item
+		 */
+		void create(index_t item);
+
+		/**
+		 * Method returns size of subtree of item
+		 * @param item id of item (may be NO_ITEM)
+		 * @param forward true for counting only forward edges
+		 * @return number of items (or forward edges) in subtree
+		 */
+		index_t count(index_t item, bool forward);
+
+		/**
+		 * Method recounts size of subtree of item from its children
+		 * @param item id of item
+		 */
+		void update(index_t item);
+
+		/**
+		 * Method joins two treaps (all items of first are before second)
+		 * @param a root of first treap
+		 * @param b root of second treap
+		 * @return root of joined treap
+		 */
+		index_t merge(index_t a, index_t b);
+
+		/**
+		 * Method splits treap after given number of items
+		 * @param item root of treap
+		 * @param count number of items in first part
+		 * @param a root of first part
+		 * @param b root of second part
+		 */
+		void split(index_t item, index_t count, index_t &a, index_t &b);
+
+		/**
+		 * Method counts items (or forward edges) before item in tour
+		 * @param item id of item
+		 * @param forward true for counting only forward edges
+		 * @return number of items before item (including item for forward edges)
+		 */
+		index_t position(index_t item, bool forward);
+
+		/**
+		 * Method checks, if node exists (was not deleted)
+		 * @param node id of node
+		 * @return true, if node is part of tree
+		 */
+		bool exists(index_t node);
+	public:
+		/**
+		 * Constructor builds treap from euler tour of tree in linear time
+		 * @param tree input tree (parent array must be known)
+		 */
+		Incremental_preorder(const Tree &tree);
+
+		/**
+		 * Method inserts new leaf as last child of node
+		 * @param node id of parent of new leaf
+		 * @return id of new leaf
+		 */
+		index_t insert_leaf(index_t node);
+
+		/**
+		 * Method deletes leaf
+		 * @param node id of leaf (not root)
+		 */
+		void delete_leaf(index_t node);
+
+		/**
+		 * Method returns preorder position of node
+		 * @param node id of node
+		 * @return position of node (root has 0)
+		 */
+		index_t preorder(index_t node);
+
+		/**
+		 * Method lists nodes in preorder (linear time)
+		 * @return ids of existing nodes in preorder
+		 */
+		vector<index_t> order();
+};
+
+/**
+ * Function prints preorder of tree and then applies commands of update
+ * file, every line has one command:
+ *   + P  insert leaf under node P (id of new node is printed)
+ *   - V  delete leaf V
+ *   ? V  print node V and its preorder position
+ *   p    print whole preorder
+ * nodes inserted to sequence tree have no char, so they are printed as
+ * ids in brackets (for example ABD[12]C)
+ * @param tree input tree
+ * @param input stream of commands
+ */
+void incremental_preorder(const Tree &tree, istream &input);
+
+#endif
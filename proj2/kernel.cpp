@@ -0,0 +1,287 @@
+/**
+ * @file kernel.cpp
+ * @author Jiri Kristof <xkrist22@stud.fit.vutbr.cz>
+ * @brief File contains local list ranking kernels of project "preorder tree"
+ */
+
+#include <algorithm>
+#include <chrono>
+#include "kernel.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define LOCAL_KERNEL_X86
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+/**
+ * Type of one pointer jumping round, values are read from old arrays
+ * and written to new arrays (so there is no RAW conflict)
+ * @return true, if some element has not reached sentinel yet
+ */
+template<typename T>
+using jump_round_t = bool (*)(const T *weight, const T *tail, const T *next,
+	T *weight_new, T *tail_new, T *next_new, size_t begin, size_t count);
+
+template<typename T>
+static bool jump_scalar(const T *weight, const T *tail, const T *next,
+		T *weight_new, T *tail_new, T *next_new, size_t begin, size_t count) {
+	bool active = false;
+	for (size_t i = begin; i < count; i++) {
+		T successor = next[i];
+		weight_new[i] = weight[i] + weight[successor];
+		tail_new[i] = tail[i] + tail[successor];
+		next_new[i] = next[successor];
+		active |= next_new[i] != (T) count;
+	}
+	return active;
+}
+
+#ifdef LOCAL_KERNEL_X86
+// sentinel is valid index, so gathers need no mask
+__attribute__((target("avx2")))
+static bool jump_avx2(const int32_t *weight, const int32_t *tail, const int32_t *next,
+		int32_t *weight_new, int32_t *tail_new, int32_t *next_new, size_t begin, size_t count) {
+	__m256i sentinel = _mm256_set1_epi32(count);
+	__m256i active = _mm256_setzero_si256();
+	size_t i = begin;
+	for (; i + 8 <= count; i += 8) {
+		__m256i successor = _mm256_loadu_si256((const __m256i *) (next + i));
+		__m256i sum = _mm256_add_epi32(_mm256_loadu_si256((const __m256i *) (weight + i)),
+			_mm256_i32gather_epi32(weight, successor, 4));
+		__m256i tails = _mm256_add_epi32(_mm256_loadu_si256((const __m256i *) (tail + i)),
+			_mm256_i32gather_epi32(tail, successor, 4));
+		__m256i jumped = _mm256_i32gather_epi32(next, successor, 4);
+		_mm256_storeu_si256((__m256i *) (weight_new + i), sum);
+		_mm256_storeu_si256((__m256i *) (tail_new + i), tails);
+		_mm256_storeu_si256((__m256i *) (next_new + i), jumped);
+		active = _mm256_or_si256(active, _mm256_xor_si256(jumped, sentinel));
+	}
+	bool rest = jump_scalar(weight, tail, next, weight_new, tail_new, next_new, i, count);
+	return rest || !_mm256_testz_si256(active, active);
+}
+
+// gather with explicit source, so no lane is left undefined
+__attribute__((target("avx512f")))
+static inline __m512i gather_avx512(const int32_t *base, __m512i index) {
+	return _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), 0xFFFF, index, base, 4);
+}
+
+__attribute__((target("avx512f")))
+static bool jump_avx512(const int32_t *weight, const int32_t *tail, const int32_t *next,
+		int32_t *weight_new, int32_t *tail_new, int32_t *next_new, size_t begin, size_t count) {
+	__m512i sentinel = _mm512_set1_epi32(count);
+	__mmask16 active = 0;
+	size_t i = begin;
+	for (; i + 16 <= count; i += 16) {
+		__m512i successor = _mm512_loadu_si512(next + i);
+		__m512i sum = _mm512_add_epi32(_mm512_loadu_si512(weight + i),
+			gather_avx512(weight, successor));
+		__m512i tails = _mm512_add_epi32(_mm512_loadu_si512(tail + i),
+			gather_avx512(tail, successor));
+		__m512i jumped = gather_avx512(next, successor);
+		_mm512_storeu_si512(weight_new + i, sum);
+		_mm512_storeu_si512(tail_new + i, tails);
+		_mm512_storeu_si512(next_new + i, jumped);
+		active |= _mm512_cmpneq_epi32_mask(jumped, sentinel);
+	}
+	bool rest = jump_scalar(weight, tail, next, weight_new, tail_new, next_new, i, count);
+	return rest || active != 0;
+}
+
+// 64-bit ids, gathers of 64-bit indices have half of lanes
+__attribute__((target("avx2")))
+static bool jump_avx2(const int64_t *weight, const int64_t *tail, const int64_t *next,
+		int64_t *weight_new, int64_t *tail_new, int64_t *next_new, size_t begin, size_t count) {
+	const long long *weights = (const long long *) weight, *tails = (const long long *) tail, *nexts = (const long long *) next;
+	__m256i sentinel = _mm256_set1_epi64x(count);
+	__m256i active = _mm256_setzero_si256();
+	size_t i = begin;
+	for (; i + 4 <= count; i += 4) {
+		__m256i successor = _mm256_loadu_si256((const __m256i *) (next + i));
+		__m256i sum = _mm256_add_epi64(_mm256_loadu_si256((const __m256i *) (weight + i)),
+			_mm256_i64gather_epi64(weights, successor, 8));
+		__m256i tail_sum = _mm256_add_epi64(_mm256_loadu_si256((const __m256i *) (tail + i)),
+			_mm256_i64gather_epi64(tails, successor, 8));
+		__m256i jumped = _mm256_i64gather_epi64(nexts, successor, 8);
+		_mm256_storeu_si256((__m256i *) (weight_new + i), sum);
+		_mm256_storeu_si256((__m256i *) (tail_new + i), tail_sum);
+		_mm256_storeu_si256((__m256i *) (next_new + i), jumped);
+		active = _mm256_or_si256(active, _mm256_xor_si256(jumped, sentinel));
+	}
+	bool rest = jump_scalar(weight, tail, next, weight_new, tail_new, next_new, i, count);
+	return rest || !_mm256_testz_si256(active, active);
+}
+
+__attribute__((target("avx512f")))
+static inline __m512i gather_avx512(const int64_t *base, __m512i index) {
+	return _mm512_mask_i64gather_epi64(_mm512_setzero_si512(), 0xFF, index, base, 8);
+}
+
+__attribute__((target("avx512f")))
+static bool jump_avx512(const int64_t *weight, const int64_t *tail, const int64_t *next,
+		int64_t *weight_new, int64_t *tail_new, int64_t *next_new, size_t begin, size_t count) {
+	__m512i sentinel = _mm512_set1_epi64(count);
+	__mmask8 active = 0;
+	size_t i = begin;
+	for (; i + 8 <= count; i += 8) {
+		__m512i successor = _mm512_loadu_si512(next + i);
+		__m512i sum = _mm512_add_epi64(_mm512_loadu_si512(weight + i),
+			gather_avx512(weight, successor));
+		__m512i tails = _mm512_add_epi64(_mm512_loadu_si512(tail + i),
+			gather_avx512(tail, successor));
+		__m512i jumped = gather_avx512(next, successor);
+		_mm512_storeu_si512(weight_new + i, sum);
+		_mm512_storeu_si512(tail_new + i, tails);
+		_mm512_storeu_si512(next_new + i, jumped);
+		active |= _mm512_cmpneq_epi64_mask(jumped, sentinel);
+	}
+	bool rest = jump_scalar(weight, tail, next, weight_new, tail_new, next_new, i, count);
+	return rest || active != 0;
+}
+#endif
+
+bool local_kernel_available(int kernel) {
+	switch (kernel) {
+		case LOCAL_KERNEL_SCALAR:
+			return true;
+#ifdef LOCAL_KERNEL_X86
+		case LOCAL_KERNEL_AVX2:
+			__builtin_cpu_init();
+			return __builtin_cpu_supports("avx2");
+		case LOCAL_KERNEL_AVX512:
+			__builtin_cpu_init();
+			return __builtin_cpu_supports("avx512f");
+#endif
+		default:
+			return false;
+	}
+}
+
+// kernels chosen for LOCAL_KERNEL_AUTO for 32-bit and 64-bit elements
+static int auto_kernel[2] = {LOCAL_KERNEL_AUTO, LOCAL_KERNEL_AUTO};
+
+int local_kernel_best(size_t bytes) {
+	return auto_kernel[bytes == sizeof(int64_t)];
+}
+
+const char *local_kernel_name(int kernel) {
+	switch (kernel) {
+		case LOCAL_KERNEL_SCALAR:
+			return "scalar";
+		case LOCAL_KERNEL_AVX2:
+			return "avx2";
+		case LOCAL_KERNEL_AVX512:
+			return "avx512";
+		default:
+			return "auto";
+	}
+}
+
+/**
+ * Function runs rounds of chosen kernel (see local_list_rank)
+ */
+/**
+ * Function returns round of kernel for elements of type T
+ * @param kernel one of LOCAL_KERNEL_* values (available on this CPU)
+ * @return pointer jumping round of kernel
+ */
+template<typename T>
+static jump_round_t<T> kernel_round(int kernel) {
+#ifdef LOCAL_KERNEL_X86
+	if (kernel == LOCAL_KERNEL_AVX2) {
+		return jump_avx2;
+	} else if (kernel == LOCAL_KERNEL_AVX512) {
+		return jump_avx512;
+	}
+#endif
+	return jump_scalar<T>;
+}
+
+/**
+ * Function returns next kernel available on this CPU
+ * @param kernel one of LOCAL_KERNEL_* values
+ * @return next available kernel or LOCAL_KERNELS_COUNT
+ */
+static int next_available(int kernel) {
+	do {
+		kernel++;
+	} while (kernel < LOCAL_KERNELS_COUNT && !local_kernel_available(kernel));
+	return kernel;
+}
+
+/**
+ * Function runs rounds of chosen kernel (see local_list_rank)
+ */
+template<typename T>
+static void list_rank(vector<T> &weight, vector<T> &tail, vector<T> &next, int kernel) {
+	size_t count = next.size() - 1;
+	int &chosen = auto_kernel[sizeof(T) == sizeof(int64_t)];
+
+	// gathers of wider kernels do not pay off on every CPU, so kernel
+	// of LOCAL_KERNEL_AUTO is measured on first rounds of first long
+	// list, every round processes whole list, so rounds of different
+	// kernels are comparable (short lists are ranked by scalar kernel)
+	bool measure = false;
+	if (kernel == LOCAL_KERNEL_AUTO && count < KERNEL_PROBE_LENGTH) {
+		kernel = LOCAL_KERNEL_SCALAR;
+	} else if (kernel == LOCAL_KERNEL_AUTO && chosen != LOCAL_KERNEL_AUTO) {
+		kernel = chosen;
+	} else if (kernel == LOCAL_KERNEL_AUTO) {
+		measure = true;
+		kernel = LOCAL_KERNEL_SCALAR;
+	} else if (!local_kernel_available(kernel)) {
+		kernel = LOCAL_KERNEL_SCALAR;
+	}
+	int fastest = LOCAL_KERNEL_SCALAR;
+	double scalar_time = 0, fastest_time = 0, kernel_time = 0;
+	int kernel_rounds = 0;
+
+	// rounds alternate between two buffers until every element
+	// reaches sentinel (at most ceil of binary log of count rounds)
+	vector<T> weight_new(weight), tail_new(tail), next_new(next);
+	bool active = false;
+	for (size_t i = 0; i < count && !active; i++) {
+		active = next[i] != (T) count;
+	}
+	while (active) {
+		auto start = chrono::steady_clock::now();
+		active = kernel_round<T>(kernel)(weight.data(), tail.data(), next.data(),
+			weight_new.data(), tail_new.data(), next_new.data(), 0, count);
+		double time = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+		weight.swap(weight_new);
+		tail.swap(tail_new);
+		next.swap(next_new);
+
+		if (measure) {
+			// best of KERNEL_PROBE_ROUNDS rounds is time of kernel, vector
+			// kernel must beat scalar one by KERNEL_MIN_SPEEDUP (scalar
+			// kernel is measured first)
+			kernel_time = kernel_rounds == 0 ? time : min(kernel_time, time);
+			if (++kernel_rounds < KERNEL_PROBE_ROUNDS) {
+				continue;
+			}
+			if (kernel == LOCAL_KERNEL_SCALAR) {
+				scalar_time = fastest_time = kernel_time;
+			} else if (kernel_time * KERNEL_MIN_SPEEDUP < scalar_time && kernel_time < fastest_time) {
+				fastest = kernel;
+				fastest_time = kernel_time;
+			}
+			kernel_rounds = 0;
+			kernel = next_available(kernel);
+			if (kernel == LOCAL_KERNELS_COUNT) {
+				measure = false;
+				kernel = chosen = fastest;
+			}
+		}
+	}
+}
+
+void local_list_rank(vector<int32_t> &weight, vector<int32_t> &tail, vector<int32_t> &next, int kernel) {
+	list_rank(weight, tail, next, kernel);
+}
+
+void local_list_rank(vector<int64_t> &weight, vector<int64_t> &tail, vector<int64_t> &next, int kernel) {
+	list_rank(weight, tail, next, kernel);
+}
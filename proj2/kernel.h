@@ -0,0 +1,81 @@
+/**
+ * @file kernel.h
+ * @author Jiri Kristof, <xkrist22@stud.fit.vutbr.cz>
+ * @brief header file of local list ranking kernels of project "preorder tree"
+ *
+ * part of euler tour stored in block of one process is ranked locally
+ * before any exchange, one round of pointer jumping is pure gather
+ * over local arrays, so it is vectorized by AVX2 and AVX-512 gathers,
+ * kernel is selected at runtime among kernels supported by CPU by
+ * timing their rounds on first long list (64-bit ids halve lanes of
+ * gathers, 32-bit kernels are kept for INDEX32 builds)
+ */
+
+#ifndef KERNEL_H
+#define KERNEL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+// kernels of one pointer jumping round
+#define LOCAL_KERNEL_AUTO -1
+#define LOCAL_KERNEL_SCALAR 0
+#define LOCAL_KERNEL_AVX2 1
+#define LOCAL_KERNEL_AVX512 2
+#define LOCAL_KERNELS_COUNT 3
+
+// shorter lists are ranked by scalar kernel without measuring kernels
+#define KERNEL_PROBE_LENGTH (1 << 16)
+
+// measured rounds of every kernel and speedup of one round, which
+// vector kernel must reach against scalar one to be chosen
+#define KERNEL_PROBE_ROUNDS 2
+#define KERNEL_MIN_SPEEDUP 1.1
+
+using namespace std;
+
+/**
+ * Function checks, if kernel can run on this CPU
+ * @param kernel one of LOCAL_KERNEL_* values
+ * @return true, if kernel is compiled in and CPU supports it
+ */
+bool local_kernel_available(int kernel);
+
+/**
+ * Function returns kernel used for LOCAL_KERNEL_AUTO, it is fastest
+ * kernel measured on rounds of first list of at least
+ * KERNEL_PROBE_LENGTH elements
+ * @param bytes size of one element (4 or 8)
+ * @return fastest available kernel, LOCAL_KERNEL_AUTO if it is not
+ * measured yet
+ */
+int local_kernel_best(size_t bytes);
+
+/**
+ * Function returns name of kernel
+ * @param kernel one of LOCAL_KERNEL_* values
+ * @return name of kernel
+ */
+const char *local_kernel_name(int kernel);
+
+/**
+ * Function ranks local runs of list by pointer jumping, run is maximal
+ * sequence of elements linked by local successors
+ *
+ * arrays have one element more than list, last element (index count)
+ * is sentinel with weight 0, tail 0 and itself as successor, last
+ * element of run has sentinel as successor
+ *
+ * after ranking, weight of element is sum of weights from element
+ * to end of its run and tail is sum of tails on same elements (so
+ * if only last element of run has nonzero tail, every element gets it)
+ * @param weight weights of elements, replaced by sums
+ * @param tail tails of elements, replaced by sums
+ * @param next indices of local successors, replaced by index of sentinel
+ * @param kernel one of LOCAL_KERNEL_* values
+ */
+void local_list_rank(vector<int32_t> &weight, vector<int32_t> &tail, vector<int32_t> &next, int kernel = LOCAL_KERNEL_AUTO);
+void local_list_rank(vector<int64_t> &weight, vector<int64_t> &tail, vector<int64_t> &next, int kernel = LOCAL_KERNEL_AUTO);
+
+#endif
@@ -0,0 +1,113 @@
+/**
+ * @file lca.cpp
+ * @author Jiri Kristof <xkrist22@stud.fit.vutbr.cz>
+ * @brief File contains lowest common ancestor queries of project "preorder tree"
+ */
+
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include "lca.h"
+#include "threads.h"
+#include "profile.h"
+
+using namespace std;
+
+Lca_index::Lca_index(const Tree &tree, const vector<numbers_t> &numbers, int threads) {
+	index_t node_count = tree.get_node_count();
+	index_t length = 2 * node_count - 1;
+	this->first.resize(node_count);
+	this->pre.resize(node_count);
+	this->size.resize(node_count);
+	this->tour.assign(length, tree.get_root());
+	this->depth.assign(length, 0);
+
+	// every node writes its first occurrence and return to its parent,
+	// so tour is filled in parallel without walking it
+	Thread_pool pool = Thread_pool(threads);
+	pool.parallel_for(0, node_count, [&](index_t node) {
+		index_t first = 2 * numbers[node][0] - numbers[node][2];
+		this->first[node] = first;
+		this->pre[node] = numbers[node][0];
+		this->size[node] = numbers[node][3];
+		this->tour[first] = node;
+		this->depth[first] = numbers[node][2];
+		if (node != tree.get_root()) {
+			index_t parent = tree.get_parent(node);
+			this->tour[first + 2 * numbers[node][3] - 1] = parent;
+			this->depth[first + 2 * numbers[node][3] - 1] = numbers[node][2] - 1;
+		}
+	});
+
+	// level k is built from level k - 1, items of level are independent
+	this->table.push_back(vector<index_t>(length));
+	pool.parallel_for(0, length, [&](index_t i) {
+		this->table[0][i] = i;
+	});
+	for (int k = 1; ((index_t) 1 << k) <= length; k++) {
+		index_t count = length - ((index_t) 1 << k) + 1;
+		this->table.push_back(vector<index_t>(count));
+		const vector<index_t> &lower = this->table[k - 1];
+		vector<index_t> &level = this->table[k];
+		pool.parallel_for(0, count, [&](index_t i) {
+			level[i] = this->shallower(lower[i], lower[i + ((index_t) 1 << (k - 1))]);
+		});
+	}
+}
+
+index_t Lca_index::shallower(index_t a, index_t b) const {
+	return this->depth[b] < this->depth[a] ? b : a;
+}
+
+bool Lca_index::is_ancestor(index_t u, index_t v) const {
+	return this->pre[u] <= this->pre[v] && this->pre[v] < this->pre[u] + this->size[u];
+}
+
+index_t Lca_index::lca(index_t u, index_t v) const {
+	index_t begin = min(this->first[u], this->first[v]);
+	index_t end = max(this->first[u], this->first[v]);
+	// two ranges of length 2^k cover whole range
+	int k = 63 - __builtin_clzll(end - begin + 1);
+	return this->tour[this->shallower(this->table[k][begin], this->table[k][end - ((index_t) 1 << k) + 1])];
+}
+
+void lca_queries(const Tree &tree, const Lca_index &index, istream &input) {
+	// whole output is built in memory and written at once
+	string result;
+	index_t u, v;
+	while (input >> u >> v) {
+		if (u < 0 || u >= tree.get_node_count() || v < 0 || v >= tree.get_node_count()) {
+			throw "Unknown node in query";
+		}
+		result += tree.label(index.lca(u, v));
+		result += index.is_ancestor(u, v) ? " 1\n" : " 0\n";
+	}
+	if (!input.eof()) {
+		throw "Query contains non-integer value";
+	}
+	fwrite(result.data(), 1, result.size(), stdout);
+}
+
+void block_lca_queries(Options options, const Tree &tree, int rank, int size) {
+	/**** TREE NUMBERS ****/
+	vector<numbers_t> numbers = block_numbers(options, tree, rank, size);
+	if (rank != PROC_MAIN) {
+		return;
+	}
+
+	/**** LCA INDEX ****/
+	Profile::phase("LCA INDEX");
+	int threads = options.threads > 0 ? options.threads : max(1, (int) thread::hardware_concurrency());
+	Lca_index index = Lca_index(tree, numbers, threads);
+
+	/**** ANSWER QUERIES ****/
+	Profile::phase("ANSWER QUERIES");
+	ifstream file;
+	if (options.queries != INPUT_STDIN) {
+		file.open(options.queries);
+		if (!file.is_open()) {
+			throw "Cannot open query file";
+		}
+	}
+	lca_queries(tree, index, options.queries == INPUT_STDIN ? cin : file);
+}
@@ -0,0 +1,96 @@
+/**
+ * @file lca.h
+ * @author Jiri Kristof, <xkrist22@stud.fit.vutbr.cz>
+ * @brief header file of lowest common ancestor queries of project "preorder tree"
+ *
+ * preorder, depth and subtree size of every node are counted by one
+ * suffix sum in block mode (see block_numbers), then main process
+ * builds index over euler tour of nodes, so every query is answered
+ * in constant time
+ */
+
+#ifndef LCA_H
+#define LCA_H
+
+#include <istream>
+#include "pro.h"
+#include "computation.h"
+
+/**
+ * Class answers lowest common ancestor and ancestor queries
+ *
+ * tour of nodes (root and then end node of every edge of euler tour)
+ * has 2n - 1 items, node v occurs first at index 2 pre(v) - depth(v)
+ * (forward edges of nodes before v and reverse edges of those, which
+ * are not ancestors of v, precede it) and after its subtree, reverse
+ * edge returns to parent at index first(v) + 2 size(v) - 1
+ *
+ * lowest common ancestor of u and v is item of minimal depth between
+ * their first occurrences, it is found by sparse table (level k holds
+ * index of minimum of 2^k items starting at index), so query reads
+ * two overlapping ranges of level given by length of range
+ */
+class Lca_index {
+	private:
+		vector<index_t> first;
+		vector<index_t> pre;
+		vector<index_t> size;
+		vector<index_t> tour;
+		vector<index_t> depth;
+		vector<vector<index_t>> table;
+
+		/**
+		 * Method returns index of item with lower depth
+		 * @param a index of first item in tour
+		 * @param b index of second item in tour
+		 * @return index of shallower item
+		 */
+		index_t shallower(index_t a, index_t b) const;
+	public:
+		/**
+		 * Constructor builds tour and sparse table, every level is
+		 * built by threads (levels follow each other)
+		 * @param tree input tree (parent array must be known)
+		 * @param numbers tree numbers of every node (see block_numbers)
+		 * @param threads number of threads building table
+		 */
+		Lca_index(const Tree &tree, const vector<numbers_t> &numbers, int threads);
+
+		/**
+		 * Method checks, if node is ancestor of other node
+		 * @param u id of possible ancestor
+		 * @param v id of node
+		 * @return true, if u is on path from root to v (including v)
+		 */
+		bool is_ancestor(index_t u, index_t v) const;
+
+		/**
+		 * Method returns lowest common ancestor of nodes
+		 * @param u id of first node
+		 * @param v id of second node
+		 * @return id of deepest node, which is ancestor of both
+		 */
+		index_t lca(index_t u, index_t v) const;
+};
+
+/**
+ * Function answers queries of query file, every line has pair of ids
+ * "U V" and answer is line with lowest common ancestor of U and V and
+ * 1 or 0 for U being (or not being) ancestor of V
+ * @param tree input tree
+ * @param index index built over tree
+ * @param input stream of queries
+ */
+void lca_queries(const Tree &tree, const Lca_index &index, istream &input);
+
+/**
+ * Function counts tree numbers in block mode and answers queries of
+ * query file by main process (collective, see block_numbers)
+ * @param options settings given on command line
+ * @param tree input tree (whole tree on main process)
+ * @param rank rank of calling process
+ * @param size total number of processes
+ */
+void block_lca_queries(Options options, const Tree &tree, int rank, int size);
+
+#endif
@@ -0,0 +1,141 @@
+/**
+ * @file mapped.h
+ * @author Jiri Kristof, <xkrist22@stud.fit.vutbr.cz>
+ * @brief header file of arrays stored in memory or in mapped files of project "preorder tree"
+ *
+ * arrays of size of tree are either allocated in memory or mapped from
+ * file (see -x flag), pages of mapped file are loaded only when touched
+ * and they can be written back to file by kernel, so process holding
+ * such array does not need memory of its size
+ */
+
+#ifndef MAPPED_H
+#define MAPPED_H
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <string>
+#include <memory>
+#include <algorithm>
+
+using namespace std;
+
+/**
+ * Class represents array of trivially copyable items in memory or in
+ * mapped file, copies of object share same items (array is freed or
+ * unmapped with last copy)
+ *
+ * scratch file (not kept) is removed right after mapping, so it
+ * disappears even if program is killed, kept file stays for other
+ * processes, which map it read only
+ */
+template<typename T>
+class Mapped_array {
+	private:
+		shared_ptr<T> storage;
+		size_t length;
+		bool mapped;
+
+		/**
+		 * Method maps file as array
+		 * @param file_name path of file
+		 * @param create true for creating file of array size (writable),
+		 *		false for mapping existing file (read only)
+		 */
+		void map(string file_name, bool create) {
+			size_t bytes = max((size_t) 1, this->length) * sizeof(T);
+			int descriptor = create ? open(file_name.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644) : open(file_name.c_str(), O_RDONLY);
+			struct stat status;
+			if (descriptor < 0 || (create ? ftruncate(descriptor, bytes) != 0
+					: fstat(descriptor, &status) != 0 || (size_t) status.st_size != this->length * sizeof(T))) {
+				if (descriptor >= 0) {
+					close(descriptor);
+				}
+				throw "Cannot map file";
+			}
+			void *address = mmap(NULL, bytes, create ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, descriptor, 0);
+			close(descriptor);
+			if (address == MAP_FAILED) {
+				throw "Cannot map file";
+			}
+			this->storage = shared_ptr<T>((T *) address, [bytes](T *pointer) { munmap(pointer, bytes); });
+			this->mapped = true;
+		}
+	public:
+		/**
+		 * Constructor of empty array
+		 */
+		Mapped_array() {
+			this->length = 0;
+			this->mapped = false;
+		}
+
+		/**
+		 * Constructor allocates array of zero items
+		 * @param length number of items
+		 * @param file_name path of mapped file (empty for memory)
+		 * @param keep false for scratch file, which is removed after mapping
+		 */
+		Mapped_array(size_t length, string file_name = "", bool keep = false) {
+			this->length = length;
+			this->mapped = false;
+			if (file_name.empty()) {
+				this->storage = shared_ptr<T>(new T[max((size_t) 1, length)](), default_delete<T[]>());
+				return;
+			}
+			this->map(file_name, true);
+			if (!keep) {
+				unlink(file_name.c_str());
+			}
+		}
+
+		/**
+		 * Method maps existing file created by other process (read only)
+		 * @param file_name path of file
+		 * @param length number of items (must match size of file)
+		 * @return array of items of file
+		 */
+		static Mapped_array open_file(string file_name, size_t length) {
+			Mapped_array array;
+			array.length = length;
+			array.map(file_name, false);
+			return array;
+		}
+
+		/**
+		 * Method writes changed pages of mapped file (nothing for memory)
+		 * @return true, if pages were written
+		 */
+		bool sync() {
+			return !this->mapped || msync(this->storage.get(), max((size_t) 1, this->length) * sizeof(T), MS_SYNC) == 0;
+		}
+
+		/**
+		 * Operators give access to items
+		 * @param i index of item
+		 * @return item of array
+		 */
+		T &operator[](size_t i) const {
+			return this->storage.get()[i];
+		}
+
+		/**
+		 * Getter of items
+		 * @return pointer to first item
+		 */
+		T *data() const {
+			return this->storage.get();
+		}
+
+		/**
+		 * Getter of number of items
+		 * @return number of items
+		 */
+		size_t size() const {
+			return this->length;
+		}
+};
+
+#endif
@@ -4,271 +4,1295 @@
  * @brief File contains parallel implementation of algorithm "preorder tree"
  */
 
+#include <unistd.h>
+#include <fstream>
+#include <iostream>
 #include "pro.h"
+#include "threads.h"
+#include "engine.h"
+#include "kernel.h"
+#include "incremental.h"
+#include "server.h"
+#include "lca.h"
+#include "computation.h"
+#include "profile.h"
 
 using namespace std;
 
-/// edge id counter initialization
-int Edge::id_counter = 1;
+Edge_store::Edge_store() {
+	this->edge_count = 0;
+	this->head = 0;
+	this->ending_edge = 0;
+	this->target = NULL;
+	this->euler_next = NULL;
+}
+
+Edge_store::Edge_store(const Tree &tree, string map_file, Thread_pool *pool) {
+	index_t node_count = tree.get_node_count();
+	const vector<index_t> &roots = tree.get_roots();
+	this->edge_count = 2 * (node_count - roots.size());
+	this->allocate(map_file, true);
+
+	// loops without dependencies between iterations run on pool, if
+	// it is given (serial loop keeps body inlined)
+	auto each = [&](index_t begin, index_t end, auto body) {
+		if (pool != NULL) {
+			pool->parallel_for(begin, end, body);
+		} else {
+			for (index_t i = begin; i < end; i++) {
+				body(i);
+			}
+		}
+	};
+
+	// pair of edges for every node except roots
+	each(1, this->edge_count / 2 + 1, [&](index_t slot) {
+		index_t child = tree.slot_node(slot);
+		this->target[2 * slot - 1] = child;
+		this->target[2 * slot] = tree.get_parent(child);
+	});
+
+	// adj lists stored one after another (counting sort by start node),
+	// reverse edge is first in list of child and forward edges follow
+	// in order of ids of children, with mapped store these arrays are
+	// scratch files too (removed right after mapping)
+	Mapped_array<index_t> first_edge = Mapped_array<index_t>(node_count + 1, map_file.empty() ? "" : map_file + SCRATCH_FIRST);
+	each(1, this->edge_count + 1, [&](index_t i) {
+		index_t *count = &first_edge[this->get_source(i) + 1];
+		if (pool != NULL) {
+			__atomic_fetch_add(count, 1, __ATOMIC_RELAXED);
+		} else {
+			(*count)++;
+		}
+	});
+	for (index_t i = 0; i < node_count; i++) {
+		first_edge[i + 1] += first_edge[i];
+	}
+	Mapped_array<index_t> edges = Mapped_array<index_t>(this->edge_count, map_file.empty() ? "" : map_file + SCRATCH_EDGES);
+	Mapped_array<index_t> position = Mapped_array<index_t>(node_count, map_file.empty() ? "" : map_file + SCRATCH_POSITION);
+	each(0, node_count, [&](index_t child) {
+		position[child] = first_edge[child];
+		if (tree.get_parent(child) != NO_PARENT) {
+			edges[position[child]++] = 2 * tree.edge_slot(child);
+		}
+	});
+	// forward edges keep order of children, so they are placed serially
+	for (index_t child = 0; child < node_count; child++) {
+		if (tree.get_parent(child) != NO_PARENT) {
+			index_t parent = tree.get_parent(child);
+			edges[position[parent]++] = 2 * tree.edge_slot(child) - 1;
+		}
+	}
+
+	// successor of edge is edge following its reverse edge in list
+	// (first edge of list follows last one)
+	each(0, node_count, [&](index_t node) {
+		index_t begin = first_edge[node];
+		index_t end = first_edge[node + 1];
+		for (index_t i = begin; i < end; i++) {
+			index_t next = i + 1 < end ? edges[i + 1] : edges[begin];
+			this->euler_next[this->get_reverse_id(edges[i])] = next;
+		}
+	});
+
+	// tour of every tree of forest ends by its own ending edge, so
+	// lists of trees are separated (roots without children have no tour)
+	this->head = 0;
+	this->ending_edge = 0;
+	for (index_t i = (index_t) roots.size() - 1; i >= 0; i--) {
+		index_t root = roots[i];
+		if (first_edge[root] == first_edge[root + 1]) {
+			continue;
+		}
+		this->head = edges[first_edge[root]];
+		this->ending_edge = this->get_reverse_id(edges[first_edge[root + 1] - 1]);
+		this->euler_next[this->ending_edge] = this->ending_edge;
+	}
+}
+
+void Edge_store::allocate(string map_file, bool create) {
+	// pages of mapped file are loaded only when touched, so process
+	// reading its block does not hold whole store in memory
+	size_t length = 2 * ((size_t) this->edge_count + 1);
+	try {
+		if (map_file.empty()) {
+			this->storage = Mapped_array<index_t>(length);
+		} else if (create) {
+			this->storage = Mapped_array<index_t>(length, map_file, true);
+		} else {
+			this->storage = Mapped_array<index_t>::open_file(map_file, length);
+		}
+	} catch (const char *error) {
+		throw "Cannot map edge store file";
+	}
+	this->target = this->storage.data();
+	this->euler_next = this->storage.data() + this->edge_count + 1;
+}
+
+void Edge_store::broadcast(int rank, string map_file) {
+	index_t values[3] = {this->edge_count, this->head, this->ending_edge};
+	MPI_Bcast(values,3,MPI_INDEX,PROC_MAIN,MPI_COMM_WORLD);
+	if (rank != PROC_MAIN) {
+		this->edge_count = values[0];
+		this->head = values[1];
+		this->ending_edge = values[2];
+	}
+	if (map_file.empty()) {
+		if (rank != PROC_MAIN) {
+			this->allocate(map_file, false);
+		}
+		broadcast_values(this->target, this->edge_count + 1);
+		broadcast_values(this->euler_next, this->edge_count + 1);
+		return;
+	}
 
-Edge::Edge(char start_node, char end_node) {
-	this->start_node = start_node;
-	this->end_node = end_node;
-	this->id = Edge::id_counter;
-	Edge::id_counter++;
+	// store written by main process is mapped by others (file must be
+	// visible to every process), error of any process is broadcast
+	int failed = 0;
+	if (rank == PROC_MAIN) {
+		failed = !this->storage.sync();
+	} else {
+		try {
+			this->allocate(map_file, false);
+		} catch (const char *error) {
+			failed = 1;
+		}
+	}
+	MPI_Allreduce(MPI_IN_PLACE,&failed,1,MPI_INT,MPI_MAX,MPI_COMM_WORLD);
+	if (failed) {
+		throw "Cannot map edge store file";
+	}
 }
 
-int Edge::get_id() {
-	return this->id;
+index_t Edge_store::get_edge_count() const {
+	return this->edge_count;
 }
 
-char Edge::get_start_node() {
-	return this->start_node;
+index_t Edge_store::get_head() const {
+	return this->head;
 }
 
-char Edge::get_end_node() {
-	return this->end_node;
+index_t Edge_store::get_ending_edge() const {
+	return this->ending_edge;
 }
 
-Adj_elem::Adj_elem(char node_id, int forward_id, int reverse_id, bool inserted_as_forward) {
-	this->forward_id = forward_id;
-	this->reverse_id = reverse_id;
-	this->node_id = node_id;
-	this->inserted_as_forward = inserted_as_forward;
+index_t Edge_store::get_source(index_t edge_id) const {
+	return this->target[this->get_reverse_id(edge_id)];
 }
 
-int Adj_elem::get_forward_id() {
-	return this->forward_id;
+index_t Edge_store::get_target(index_t edge_id) const {
+	return this->target[edge_id];
 }
 
-int Adj_elem::get_reverse_id() {
-	return this->reverse_id;
+index_t Edge_store::get_reverse_id(index_t edge_id) const {
+	return edge_id % 2 == 1 ? edge_id + 1 : edge_id - 1;
 }
 
-char Adj_elem::get_node_id() {
-	return this->node_id;
+index_t Edge_store::get_euler_next(index_t edge_id) const {
+	return this->euler_next[edge_id];
 }
 
-bool Adj_elem::is_forward_elem() {
-	return this->inserted_as_forward;
+bool Edge_store::is_forward(index_t edge_id) const {
+	return edge_id % 2 == 1;
 }
 
-int Nodes::get_preorder_position() {
-	return this->preorder_position;
+Edge_block::Edge_block(index_t edge_count, int size, int first_rank) {
+	this->edge_count = edge_count;
+	this->size = size - first_rank;
+	this->first_rank = first_rank;
 }
 
-char Nodes::get_node_name() {
-	return this->node_name;
+index_t Edge_block::start(int index) {
+	return (index_t) (((__int128) (index - this->first_rank) * this->edge_count) / this->size) + 1;
 }
 
-Nodes::Nodes(int preorder_position, char name) {
-	this->preorder_position = preorder_position;
-	this->node_name = name;
+index_t Edge_block::first(int rank) {
+	if (rank < this->first_rank) {
+		return 1;
+	}
+	// rank after last process gives end of last block
+	return this->start(rank >= this->placement.size() ? rank : this->placement[rank]);
 }
 
-int main(int argc, char** argv) {
-	// first at all, check, if there is any argument
-	if (argc < 2) {
+index_t Edge_block::count(int rank) {
+	if (rank < this->first_rank) {
 		return 0;
 	}
-	
-	// input tree in form of array
-	string node_list = argv[1];
+	int index = rank >= this->placement.size() ? rank : this->placement[rank];
+	return this->start(index + 1) - this->start(index);
+}
+
+int Edge_block::owner(index_t edge_id) {
+	int index = (int) (((__int128) this->size * edge_id - 1) / this->edge_count) + this->first_rank;
+	return this->holder.empty() ? index : this->holder[index];
+}
+
+index_t Edge_block::local_index(index_t edge_id) {
+	return edge_id - this->first(this->owner(edge_id));
+}
+
+void Edge_block::place(vector<int> placement) {
+	this->placement = placement;
+	this->holder.assign(placement.size(), 0);
+	for (int rank = 0; rank < placement.size(); rank++) {
+		this->holder[placement[rank]] = rank;
+	}
+}
+
+Options::Options(int argc, char** argv) {
+	this->block = false;
+	this->adjacency = false;
+	this->rma = false;
+	this->ruling_set = false;
+	this->nonblocking = false;
+	this->threads = 0;
+	this->sequential = false;
+	this->auto_engine = false;
+	this->input_format = FORMAT_PARENTS;
+	this->parallel_input = false;
+	this->forest = false;
+	this->placement = false;
+	this->error = NULL;
+	for (int i = 1; i < argc; i++) {
+		string arg = argv[i];
+		if (arg == FLAG_BLOCK) {
+			this->block = true;
+		} else if (arg == FLAG_ADJACENCY) {
+			this->adjacency = true;
+		} else if (arg == FLAG_RMA) {
+			this->rma = true;
+		} else if (arg == FLAG_RULING_SET) {
+			this->ruling_set = true;
+		} else if (arg == FLAG_NONBLOCKING) {
+			this->nonblocking = true;
+		} else if (arg == FLAG_PARALLEL_INPUT) {
+			this->parallel_input = true;
+		} else if (arg == FLAG_THREADS && i + 1 < argc) {
+			this->threads = max(1, atoi(argv[++i]));
+		} else if (arg == FLAG_SEQUENTIAL) {
+			this->sequential = true;
+		} else if (arg == FLAG_AUTO_ENGINE) {
+			this->auto_engine = true;
+		} else if (arg == FLAG_COST_PROFILE && i + 1 < argc) {
+			this->cost_profile = argv[++i];
+		} else if (arg == FLAG_UPDATES && i + 1 < argc) {
+			this->updates = argv[++i];
+		} else if (arg == FLAG_QUERIES && i + 1 < argc) {
+			this->queries = argv[++i];
+		} else if (arg == FLAG_OUTPUT && i + 1 < argc) {
+			this->output = argv[++i];
+		} else if (arg == FLAG_MAPPED && i + 1 < argc) {
+			this->mapped = argv[++i];
+		} else if (arg == FLAG_PLACEMENT) {
+			this->placement = true;
+		} else if (arg == FLAG_FOREST) {
+			this->forest = true;
+		} else if (arg == FLAG_SERVE && i + 1 < argc) {
+			this->serve = argv[++i];
+		} else if (arg == FLAG_INPUT && i + 1 < argc) {
+			this->input_file = argv[++i];
+		} else if (arg == FLAG_FORMAT && i + 1 < argc) {
+			this->input_format = argv[++i];
+		} else if (arg == FLAG_NUMBERS && i + 1 < argc) {
+			this->numbers = argv[++i];
+			try {
+				tree_number_indexes(this->numbers);
+			} catch (const char *error) {
+				this->error = error;
+			}
+		} else if (arg == FLAG_PROFILE && i + 1 < argc) {
+			this->profile = argv[++i];
+		} else {
+			this->node_list = arg;
+			this->node_lists.push_back(arg);
+		}
+	}
+	// euler tour can be derived without adj list only for implicit heap
+	if (!this->input_file.empty() || this->forest) {
+		this->adjacency = true;
+	}
+}
+
+void block_suffix_sum(vector<index_t> &weight, vector<index_t> &euler_next, Edge_block block, int rank) {
+	index_t first = block.first(rank);
+	index_t count = block.count(rank);
+
+	// local arrays end by sentinel, tail is id of remote successor
+	// of last edge in run (0, if run ends by ending edge)
+	vector<index_t> local_weight(weight), tail(count + 1, 0), local_next(count + 1, count);
+	local_weight.push_back(0);
+	vector<char> run_head(count, 1);
+	for (index_t i = 0; i < count; i++) {
+		index_t next = euler_next[i];
+		if (next != first + i && block.owner(next) == rank) {
+			local_next[i] = next - first;
+			run_head[next - first] = 0;
+		} else if (next != first + i) {
+			tail[i] = next;
+		}
+	}
+	local_list_rank(local_weight, tail, local_next);
+
+	// first edges of runs form reduced list linked by tails, other
+	// edges point to themselves, so they wait until reduced list is ranked
+	vector<index_t> reduced_next(count);
+	for (index_t i = 0; i < count; i++) {
+		weight[i] = local_weight[i];
+		reduced_next[i] = run_head[i] && tail[i] != 0 ? tail[i] : first + i;
+	}
+	block_suffix_scan(weight, reduced_next, block, rank, plus<index_t>());
+
+	// edge inside run adds suffix sum of run following its run
+	vector<index_t> wanted;
+	for (index_t i = 0; i < count; i++) {
+		if (!run_head[i] && tail[i] != 0) {
+			wanted.push_back(tail[i]);
+		}
+	}
+	vector<index_t> following = block_fetch(wanted, weight, block, rank);
+	for (index_t i = 0, j = 0; i < count; i++) {
+		if (!run_head[i] && tail[i] != 0) {
+			weight[i] += following[j++];
+		}
+	}
+}
+
+void rma_suffix_sum(vector<index_t> &weight, vector<index_t> &euler_next, Edge_block block, int rank) {
+	index_t first = block.first(rank);
+	index_t count = block.count(rank);
+
+	// window contains pair (weight, euler_next) for every edge in block
+	vector<index_t> values(2 * count);
+	for (index_t i = 0; i < count; i++) {
+		values[2 * i] = weight[i];
+		values[2 * i + 1] = euler_next[i];
+	}
+	MPI_Win win;
+	MPI_Win_create(values.data(),values.size() * sizeof(index_t),sizeof(index_t),MPI_INFO_NULL,MPI_COMM_WORLD,&win);
+
+	vector<index_t> recieved(2 * count);
+	while (true) {
+		// rounds stop, when every edge is finished
+		int active = 0;
+		for (index_t i = 0; i < count && !active; i++) {
+			active = values[2 * i + 1] != first + i;
+		}
+		MPI_Allreduce(MPI_IN_PLACE,&active,1,MPI_INT,MPI_MAX,MPI_COMM_WORLD);
+		if (!active) {
+			break;
+		}
+		Profile::round();
+		// read values of successors, window is not changed until
+		// closing fence, so there is no RAW conflict
+		MPI_Win_fence(MPI_MODE_NOPUT | MPI_MODE_NOPRECEDE,win);
+		for (index_t i = 0; i < count; i++) {
+			index_t next = values[2 * i + 1];
+			if (next == first + i) {
+				continue;
+			}
+			int owner = block.owner(next);
+			if (owner == rank) {
+				recieved[2 * i] = values[2 * (next - first)];
+				recieved[2 * i + 1] = values[2 * (next - first) + 1];
+			} else {
+				MPI_Get(&recieved[2 * i],2,MPI_INDEX,owner,2 * block.local_index(next),2,MPI_INDEX,win);
+			}
+		}
+		MPI_Win_fence(MPI_MODE_NOSTORE | MPI_MODE_NOPUT | MPI_MODE_NOSUCCEED,win);
+
+		// update weights and successors, edge reading finished successor
+		// is finished too (so ending edge is not read by every process)
+		for (index_t i = 0; i < count; i++) {
+			index_t next = values[2 * i + 1];
+			if (next == first + i) {
+				continue;
+			}
+			values[2 * i] += recieved[2 * i];
+			values[2 * i + 1] = recieved[2 * i + 1] == next ? first + i : recieved[2 * i + 1];
+		}
+	}
+	MPI_Win_free(&win);
+
+	for (index_t i = 0; i < count; i++) {
+		weight[i] = values[2 * i];
+		euler_next[i] = values[2 * i + 1];
+	}
+}
+
+void ruling_set_suffix_sum(vector<index_t> &weight, vector<index_t> &euler_next, Edge_block block, int rank, index_t head) {
+	int size;
+	MPI_Comm_size(MPI_COMM_WORLD, &size);
+	index_t first = block.first(rank);
+	index_t count = block.count(rank);
+	index_t edge_count = block.first(size) - 1;
+	int stride = RULING_SET_STRIDE * max(1, utility::pointer_jumping_rounds(edge_count));
+
+	/**** WALK SUBLISTS ****/
+	// for every edge, splitter of its sublist and sum of weights
+	// from splitter to edge (inclusive) is saved
+	vector<index_t> splitter(count), prefix(count);
+	// walkers are triples (splitter, sum, current edge)
+	vector<index_t> walkers;
+	for (index_t i = 0; i < count; i++) {
+		if (utility::is_splitter(first + i, head, stride)) {
+			walkers.push_back(first + i);
+			walkers.push_back(0);
+			walkers.push_back(first + i);
+		}
+	}
+	// finished sublists are triples (splitter, sum of sublist, next splitter),
+	// sublist ending by ending edge has ending edge as next splitter
+	vector<index_t> sublists;
+	int active = 1;
+	while (active > 0) {
+		Profile::round();
+		vector<vector<index_t>> outbox(size);
+		for (int w = 0; w < walkers.size(); w += 3) {
+			index_t sublist = walkers[w];
+			index_t sum = walkers[w + 1];
+			index_t current = walkers[w + 2];
+			// walk while successor is in block of this process
+			while (true) {
+				index_t index = current - first;
+				sum += weight[index];
+				splitter[index] = sublist;
+				prefix[index] = sum;
+				index_t next = euler_next[index];
+				if (next == current || utility::is_splitter(next, head, stride)) {
+					sublists.push_back(sublist);
+					sublists.push_back(sum);
+					sublists.push_back(next);
+					break;
+				}
+				if (block.owner(next) != rank) {
+					outbox[block.owner(next)].push_back(sublist);
+					outbox[block.owner(next)].push_back(sum);
+					outbox[block.owner(next)].push_back(next);
+					break;
+				}
+				current = next;
+			}
+		}
+
+		// send walkers to owners of their next edges
+		walkers = exchange_values(outbox);
+
+		int walking = !walkers.empty();
+		MPI_Allreduce(&walking,&active,1,MPI_INT,MPI_SUM,MPI_COMM_WORLD);
+	}
+
+	/**** RANK REDUCED LIST ****/
+	vector<index_t> all_sublists = gather_values(sublists, rank);
+	index_t recv_total = all_sublists.size();
+
+	// pairs (splitter, suffix sum of splitter) sorted by splitter
+	index_t splitters_num = recv_total / 3;
+	MPI_Bcast(&splitters_num,1,MPI_INDEX,PROC_MAIN,MPI_COMM_WORLD);
+	vector<pair<index_t, index_t>> splitter_sums(splitters_num);
+	if (rank == PROC_MAIN) {
+		// sublists sorted by splitter, next splitter is found by binary search
+		vector<pair<index_t, pair<index_t, index_t>>> reduced;
+		for (index_t i = 0; i < recv_total; i += 3) {
+			reduced.push_back(make_pair(all_sublists[i], make_pair(all_sublists[i + 1], all_sublists[i + 2])));
+		}
+		sort(reduced.begin(), reduced.end());
+		// walk reduced list from head and count suffix sums backwards
+		vector<index_t> order;
+		index_t current = head;
+		while (true) {
+			index_t index = lower_bound(reduced.begin(), reduced.end(), make_pair(current, make_pair(numeric_limits<index_t>::min(), numeric_limits<index_t>::min()))) - reduced.begin();
+			order.push_back(index);
+			index_t next = reduced[index].second.second;
+			if (!utility::is_splitter(next, head, stride) || next == reduced[index].first) {
+				break;
+			}
+			current = next;
+		}
+		index_t sum = 0;
+		for (index_t i = order.size() - 1; i >= 0; i--) {
+			sum += reduced[order[i]].second.first;
+			splitter_sums[order[i]] = make_pair(reduced[order[i]].first, sum);
+		}
+	}
+	broadcast_values(splitter_sums.data(), splitters_num);
+
+	/**** SUFFIX SUM ****/
+	// suffix sum of edge = suffix sum of its splitter - prefix before edge
+	for (index_t i = 0; i < count; i++) {
+		index_t index = lower_bound(splitter_sums.begin(), splitter_sums.end(), make_pair(splitter[i], numeric_limits<index_t>::min())) - splitter_sums.begin();
+		weight[i] = splitter_sums[index].second - prefix[i] + weight[i];
+	}
+}
+
+void nonblocking_suffix_sum(int &weight, int &euler_next, int edge_id, int head, int ending_edge) {
+	// ending edge has neutral weight and it is not part of list
+	if (edge_id == ending_edge) {
+		weight = 0;
+		return;
+	}
+	int next = euler_next == ending_edge ? NO_EDGE : euler_next;
+
+	// every edge except head learns its predecessor
+	int pred = NO_EDGE;
+	MPI_Request requests[4];
+	int request_num = 0;
+	if (edge_id != head) {
+		MPI_Irecv(&pred,1,MPI_INT,MPI_ANY_SOURCE,EULER_PREDECESSOR,MPI_COMM_WORLD,&requests[request_num++]);
+	}
+	if (next != NO_EDGE) {
+		MPI_Isend(&edge_id,1,MPI_INT,next,EULER_PREDECESSOR,MPI_COMM_WORLD,&requests[request_num++]);
+	}
+	MPI_Waitall(request_num,requests,MPI_STATUSES_IGNORE);
+
+	// messages are matched by source, successors only move forward and
+	// predecessors only backward, so no process sends same kind of
+	// message to same process twice and rounds cannot mix
+	while (next != NO_EDGE || pred != NO_EDGE) {
+		Profile::round();
+		int values[2] = {weight, next};
+		int recieved_values[2];
+		int recieved_pred;
+		request_num = 0;
+		if (next != NO_EDGE) {
+			MPI_Irecv(recieved_values,2,MPI_INT,next,VALUES_PACKED,MPI_COMM_WORLD,&requests[request_num++]);
+			MPI_Isend(&pred,1,MPI_INT,next,VALUES_PREDECESSOR,MPI_COMM_WORLD,&requests[request_num++]);
+		}
+		if (pred != NO_EDGE) {
+			MPI_Irecv(&recieved_pred,1,MPI_INT,pred,VALUES_PREDECESSOR,MPI_COMM_WORLD,&requests[request_num++]);
+			MPI_Isend(values,2,MPI_INT,pred,VALUES_PACKED,MPI_COMM_WORLD,&requests[request_num++]);
+		}
+		MPI_Waitall(request_num,requests,MPI_STATUSES_IGNORE);
+
+		if (next != NO_EDGE) {
+			weight += recieved_values[0];
+			next = recieved_values[1];
+		}
+		if (pred != NO_EDGE) {
+			pred = recieved_pred;
+		}
+	}
+	euler_next = ending_edge;
+}
+
+void distributed_check_tree(const Tree &tree, int rank, int size) {
+	index_t root = tree.get_root();
+	index_t node_first = tree.get_slice_first();
+	index_t node_num = tree.get_slice_count();
+	// nodes are split as edges, node with id c is at position c + 1
+	Edge_block nodes = Edge_block(tree.get_node_count(), size);
+	vector<index_t> ancestor(node_num);
+	for (index_t i = 0; i < node_num; i++) {
+		ancestor[i] = node_first + i == root ? root : tree.get_parent(node_first + i);
+	}
+
+	int rounds = utility::pointer_jumping_rounds(tree.get_node_count());
+	int active = 1;
+	for (int round = 0; round < rounds && active; round++) {
+		vector<index_t> wanted;
+		for (index_t i = 0; i < node_num; i++) {
+			if (ancestor[i] != root) {
+				wanted.push_back(ancestor[i] + 1);
+			}
+		}
+		active = !wanted.empty();
+		MPI_Allreduce(MPI_IN_PLACE,&active,1,MPI_INT,MPI_MAX,MPI_COMM_WORLD);
+		if (!active) {
+			break;
+		}
+		Profile::round();
+		vector<index_t> ancestors = block_fetch(wanted, ancestor, nodes, rank);
+		for (index_t i = 0, j = 0; i < node_num; i++) {
+			if (ancestor[i] != root) {
+				ancestor[i] = ancestors[j++];
+			}
+		}
+	}
+
+	int cycle = 0;
+	for (index_t i = 0; i < node_num && !cycle; i++) {
+		cycle = ancestor[i] != root;
+	}
+	MPI_Allreduce(MPI_IN_PLACE,&cycle,1,MPI_INT,MPI_MAX,MPI_COMM_WORLD);
+	if (cycle) {
+		throw "Input is not a tree (cycle found)";
+	}
+}
+
+index_t distributed_euler_tour(const Tree &tree, Edge_block block, int rank, int size,
+		vector<index_t> &euler_next, vector<bool> &forward) {
+	index_t root = tree.get_root();
+	index_t first = block.first(rank);
+	index_t count = block.count(rank);
+	// nodes are split as edges, node with id c is at position c + 1
+	Edge_block nodes = Edge_block(tree.get_node_count(), size);
+	index_t node_first = tree.get_slice_first();
+	index_t node_num = tree.get_slice_count();
+
+	/**** CHECK TREE ****/
+	// nodes on cycle would form tour without ending edge
+	distributed_check_tree(tree, rank, size);
+
+	/**** CHILDREN ****/
+	// pairs (parent, child) are sent to owner of parent
+	vector<vector<index_t>> outbox(size);
+	for (index_t i = 0; i < node_num; i++) {
+		index_t child = node_first + i;
+		if (child != root) {
+			index_t parent = tree.get_parent(child);
+			outbox[nodes.owner(parent + 1)].push_back(parent);
+			outbox[nodes.owner(parent + 1)].push_back(child);
+		}
+	}
+	vector<index_t> recieved = exchange_values(outbox);
+	vector<pair<index_t, index_t>> children;
+	children.reserve(recieved.size() / 2);
+	for (index_t i = 0; i < recieved.size(); i += 2) {
+		children.push_back(make_pair(recieved[i], recieved[i + 1]));
+	}
+	sort(children.begin(), children.end());
+
+	// children of parent are ordered by ids, pairs (child, next sibling)
+	// are sent back to owner of child
+	vector<index_t> first_child(node_num, NO_PARENT);
+	outbox.assign(size, vector<index_t>());
+	for (index_t i = 0; i < children.size(); i++) {
+		index_t parent = children[i].first;
+		index_t child = children[i].second;
+		if (i == 0 || children[i - 1].first != parent) {
+			first_child[parent - node_first] = child;
+		}
+		bool last = i + 1 == children.size() || children[i + 1].first != parent;
+		outbox[nodes.owner(child + 1)].push_back(child);
+		outbox[nodes.owner(child + 1)].push_back(last ? NO_PARENT : children[i + 1].second);
+	}
+	recieved = exchange_values(outbox);
+	vector<index_t> next_sibling(node_num, NO_PARENT);
+	for (index_t i = 0; i < recieved.size(); i += 2) {
+		next_sibling[recieved[i] - node_first] = recieved[i + 1];
+	}
+
+	/**** EULER TOUR ****/
+	// pairs (edge id, successor) are sent to owner of edge
+	index_t head = 0;
+	outbox.assign(size, vector<index_t>());
+	for (index_t i = 0; i < node_num; i++) {
+		index_t node = node_first + i;
+		if (node == root) {
+			head = 2 * tree.edge_slot(first_child[i]) - 1;
+			continue;
+		}
+		index_t parent = tree.get_parent(node);
+		index_t forward_id = 2 * tree.edge_slot(node) - 1;
+		index_t reverse_id = forward_id + 1;
+		// forward edge continues to first child, edge from leaf returns
+		index_t forward_next = first_child[i] == NO_PARENT ? reverse_id : 2 * tree.edge_slot(first_child[i]) - 1;
+		// reverse edge continues to next sibling, after last child tour
+		// returns to parent of parent, last child of root ends tour
+		index_t reverse_next;
+		if (next_sibling[i] != NO_PARENT) {
+			reverse_next = 2 * tree.edge_slot(next_sibling[i]) - 1;
+		} else if (parent == root) {
+			reverse_next = reverse_id;
+		} else {
+			reverse_next = 2 * tree.edge_slot(parent);
+		}
+		outbox[block.owner(forward_id)].push_back(forward_id);
+		outbox[block.owner(forward_id)].push_back(forward_next);
+		outbox[block.owner(reverse_id)].push_back(reverse_id);
+		outbox[block.owner(reverse_id)].push_back(reverse_next);
+	}
+	recieved = exchange_values(outbox);
+	euler_next.assign(count, 0);
+	forward.assign(count, false);
+	for (index_t i = 0; i < recieved.size(); i += 2) {
+		euler_next[recieved[i] - first] = recieved[i + 1];
+		forward[recieved[i] - first] = utility::heap_is_forward(recieved[i]);
+	}
+	MPI_Allreduce(MPI_IN_PLACE,&head,1,MPI_INDEX,MPI_MAX,MPI_COMM_WORLD);
+	return head;
+}
+
+index_t block_euler_tour(Options options, const Tree &tree, Edge_block &block, int rank, int size,
+		vector<index_t> &euler_next, vector<bool> &forward) {
+	index_t node_count = tree.get_node_count();
+	index_t first = block.first(rank);
+	index_t count = block.count(rank);
+	Edge_store edges;
+
+	// edges of tree read in parallel are built by processes owning them
+	if (tree.is_distributed()) {
+		Profile::phase("EULER TOUR");
+		return distributed_euler_tour(tree, block, rank, size, euler_next, forward);
+	}
+
+	/**** CREATE ADJ LIST AND BROADCAST ****/
+	Profile::phase("CREATE ADJ LIST AND BROADCAST");
+	// without adj list, tree is taken as implicit heap
+	if (options.adjacency) {
+		// error of main process is broadcast, so every process throws
+		int failed = 0;
+		if (rank == PROC_MAIN) {
+			try {
+				edges = Edge_store(tree, options.mapped);
+			} catch (const char *error) {
+				failed = 1;
+			}
+		}
+		MPI_Bcast(&failed,1,MPI_INT,PROC_MAIN,MPI_COMM_WORLD);
+		if (failed) {
+			throw "Cannot map edge store file";
+		}
+		edges.broadcast(rank, options.mapped);
+	}
+
+	/**** EULER TOUR ****/
+	Profile::phase("EULER TOUR");
+	// euler tour starts by first edge of root
+	index_t head = options.adjacency ? edges.get_head() : 1;
+	local_euler_tour(options, edges, node_count, first, count, euler_next, forward);
+
+	/**** PLACEMENT ****/
+	// successors are derived from edge ids, so process only derives
+	// tour of block placed to it (no edge data is moved)
+	if (options.placement && size > 1) {
+		Profile::phase("PLACEMENT");
+		place_blocks(block, euler_next, rank, size);
+		if (block.first(rank) != first) {
+			local_euler_tour(options, edges, node_count, block.first(rank), block.count(rank), euler_next, forward);
+		}
+	}
+	return head;
+}
+
+void local_euler_tour(Options options, const Edge_store &edges, index_t node_count, index_t first, index_t count,
+		vector<index_t> &euler_next, vector<bool> &forward) {
+	euler_next.assign(count, 0);
+	if (options.adjacency) {
+		for (index_t i = 0; i < count; i++) {
+			euler_next[i] = utility::euler_tour(first + i, edges);
+		}
+	} else {
+		for (index_t i = 0; i < count; i++) {
+			euler_next[i] = utility::heap_euler_tour(first + i, node_count);
+		}
+	}
+
+	forward.assign(count, false);
+	for (index_t i = 0; i < count; i++) {
+		if (options.adjacency) {
+			forward[i] = utility::is_forward(first + i, edges);
+		} else {
+			forward[i] = utility::heap_is_forward(first + i);
+		}
+	}
+}
+
+void place_blocks(Edge_block &block, const vector<index_t> &euler_next, int rank, int size) {
+	// links of tour leaving block are counted for every other block,
+	// links coming into block are known only by their sources
+	index_t first = block.first(rank);
+	vector<int> links(size, 0), incoming(size, 0);
+	for (index_t i = 0; i < euler_next.size(); i++) {
+		index_t next = euler_next[i];
+		if (next != first + i && block.owner(next) != rank) {
+			links[block.owner(next)]++;
+		}
+	}
+	MPI_Alltoall(links.data(),1,MPI_INT,incoming.data(),1,MPI_INT,MPI_COMM_WORLD);
+	vector<int> sources, source_weights, destinations, destination_weights;
+	for (int i = 0; i < size; i++) {
+		if (incoming[i] > 0) {
+			sources.push_back(i);
+			source_weights.push_back(incoming[i]);
+		}
+		if (links[i] > 0) {
+			destinations.push_back(i);
+			destination_weights.push_back(links[i]);
+		}
+	}
+
+	// with reorder, MPI gives neighbouring blocks ranks of processes
+	// close to each other (for example on same node), process with new
+	// rank r then owns block r (identity, if MPI does not reorder)
+	MPI_Comm graph;
+	MPI_Dist_graph_create_adjacent(MPI_COMM_WORLD,sources.size(),sources.data(),source_weights.data(),
+		destinations.size(),destinations.data(),destination_weights.data(),MPI_INFO_NULL,1,&graph);
+	int placed;
+	MPI_Comm_rank(graph, &placed);
+	MPI_Comm_free(&graph);
+	vector<int> placement(size);
+	MPI_Allgather(&placed,1,MPI_INT,placement.data(),1,MPI_INT,MPI_COMM_WORLD);
+	block.place(placement);
+}
+
+void block_tree_numbers(Options options, const Tree &tree, int rank, int size) {
+	index_t node_count = tree.get_node_count();
+
+	// indexes of wanted numbers (list was checked by parsing of options)
+	vector<int> wanted = tree_number_indexes(options.numbers);
+
+	vector<numbers_t> table = block_numbers(options, tree, rank, size);
+
+	/**** PRINT RESULT ****/
+	Profile::phase("PRINT RESULT");
+	if (rank == PROC_MAIN) {
+		for (index_t node = 0; node < node_count; node++) {
+			printf("%s", tree.label(node).c_str());
+			for (int j = 0; j < wanted.size(); j++) {
+				printf(" %lld", (long long) table[node][wanted[j]]);
+			}
+			printf("\n");
+		}
+	}
+}
+
+vector<numbers_t> block_numbers(Options options, const Tree &tree, int rank, int size) {
+	index_t node_count = tree.get_node_count();
+	index_t edge_count = 2 * (node_count - 1);
+
+	// pairs (node, numbers of node) of forward edges in block
+	vector<index_t> numbers;
+	if (edge_count > 0) {
+		Edge_block block = Edge_block(edge_count, size);
+
+		/**** EULER TOUR ****/
+		vector<index_t> euler_next;
+		vector<bool> forward;
+		block_euler_tour(options, tree, block, rank, size, euler_next, forward);
+
+		/**** TREE NUMBERS ****/
+		vector<pair<index_t, numbers_t>> result = block_compute(tree_numbers_computation(node_count), euler_next, forward, block, rank);
+		for (index_t i = 0; i < result.size(); i++) {
+			numbers.push_back(tree.slot_node(utility::heap_edge_child(result[i].first)));
+			for (int j = 0; j < NUMBERS_COUNT; j++) {
+				numbers.push_back(result[i].second[j]);
+			}
+		}
+	}
+
+	/**** GATHER NUMBERS ****/
+	Profile::phase("GATHER NUMBERS");
+	vector<index_t> all_numbers = gather_values(numbers, rank);
+	index_t recv_total = all_numbers.size();
+
+	// root is not end of any edge
+	vector<numbers_t> table(rank == PROC_MAIN ? node_count : 0);
+	if (rank == PROC_MAIN) {
+		table[tree.get_root()] = root_numbers(node_count);
+		for (index_t i = 0; i < recv_total; i += NUMBERS_COUNT + 1) {
+			for (int j = 0; j < NUMBERS_COUNT; j++) {
+				table[all_numbers[i]][j] = all_numbers[i + 1 + j];
+			}
+		}
+	}
+	return table;
+}
+
+void block_preorder(Options options, const Tree &tree, int rank, int size) {
+	index_t node_count = tree.get_node_count();
+	index_t edge_count = 2 * (node_count - tree.get_roots().size());
+	Edge_block block = Edge_block(edge_count, size);
+
+	/**** EULER TOUR ****/
+	vector<index_t> euler_next;
+	vector<bool> forward;
+	index_t head = block_euler_tour(options, tree, block, rank, size, euler_next, forward);
+	// block can be placed to other process than its default owner
+	index_t first = block.first(rank);
+	index_t count = block.count(rank);
+
+	/**** SET WEIGHTS ****/
+	Profile::phase("SET WEIGHTS");
+	vector<index_t> weight(count);
+	for (index_t i = 0; i < count; i++) {
+		weight[i] = forward[i] ? 1 : 0;
+	}
+
+	/**** SUM OF SUFFIX ****/
+	Profile::phase("SUM OF SUFFIX");
+	// single process has no remote successor, so there is nothing to expose,
+	// tours of forest are separate lists (each ends by its own ending edge,
+	// so sum is not carried over trees), ruling set is refused for forest
+	if (options.ruling_set) {
+		ruling_set_suffix_sum(weight, euler_next, block, rank, head);
+	} else if (options.rma && size > 1) {
+		rma_suffix_sum(weight, euler_next, block, rank);
+	} else {
+		block_suffix_sum(weight, euler_next, block, rank);
+	}
+
+	/**** PREORDER ****/
+	Profile::phase("PREORDER");
+	// pairs (edge id, preorder position) of forward edges in block, size
+	// of tree in forest is known only by main, so it gets suffix sums
+	vector<index_t> positions;
+	for (index_t i = 0; i < count; i++) {
+		if (forward[i]) {
+			positions.push_back(first + i);
+			positions.push_back(options.forest ? weight[i] : utility::preorder(weight[i], node_count));
+		}
+	}
+	if (!options.output.empty()) {
+		/**** WRITE RESULT ****/
+		Profile::phase("WRITE RESULT");
+		write_preorder(options.output, tree, positions, rank);
+		return;
+	}
+	if (!options.mapped.empty() && !options.forest) {
+		/**** WRITE RESULT ****/
+		Profile::phase("WRITE RESULT");
+		// with mapped store, result is not gathered, it is written to
+		// scratch file, which is printed from its mapping by main process
+		string file_name = options.mapped + SCRATCH_ORDER;
+		write_preorder(file_name, tree, positions, rank);
+
+		/**** PRINT RESULT ****/
+		Profile::phase("PRINT RESULT");
+		if (rank == PROC_MAIN) {
+			Mapped_array<index_t> order = Mapped_array<index_t>::open_file(file_name, node_count);
+			unlink(file_name.c_str());
+			tree.print(order.data(), order.size());
+		}
+		return;
+	}
+	vector<index_t> all_positions = gather_values(positions, rank);
+	index_t recv_total = all_positions.size();
+
+	/**** PRINT RESULT ****/
+	Profile::phase("PRINT RESULT");
+	if (rank == PROC_MAIN && options.forest) {
+		forest_print(tree, all_positions);
+	} else if (rank == PROC_MAIN) {
+		// root is in position 0, other nodes are placed by edge going into them
+		// (end node of edge is known from its id, see Tree::edge_slot)
+		vector<index_t> result(node_count);
+		result[0] = tree.get_root();
+		for (index_t i = 0; i < recv_total; i += 2) {
+			index_t edge_id = all_positions[i];
+			result[all_positions[i + 1]] = tree.slot_node(utility::heap_edge_child(edge_id));
+		}
+		tree.print(result);
+	}
+}
+
+void write_preorder(string file_name, const Tree &tree, const vector<index_t> &positions, int rank) {
+	// records (position, node) are sorted, so displacements of file
+	// view are increasing (end node of edge is known from its id)
+	vector<pair<index_t, index_t>> records;
+	if (rank == PROC_MAIN) {
+		records.push_back(make_pair(0, tree.get_root()));
+	}
+	for (index_t i = 0; i < positions.size(); i += 2) {
+		records.push_back(make_pair(positions[i + 1], tree.slot_node(utility::heap_edge_child(positions[i]))));
+	}
+	sort(records.begin(), records.end());
+	vector<MPI_Aint> displacements(records.size());
+	vector<index_t> nodes(records.size());
+	for (size_t i = 0; i < records.size(); i++) {
+		displacements[i] = (MPI_Aint) records[i].first * sizeof(index_t);
+		nodes[i] = records[i].second;
+	}
+	records.clear();
+	records.shrink_to_fit();
+
+	// errors of collective calls are same on every process
+	MPI_File file;
+	if (MPI_File_open(MPI_COMM_WORLD,(char *) file_name.c_str(),MPI_MODE_CREATE | MPI_MODE_WRONLY,
+			MPI_INFO_NULL,&file) != MPI_SUCCESS) {
+		throw "Cannot open output file";
+	}
+	MPI_File_set_size(file,(MPI_Offset) sizeof(index_t) * tree.get_node_count());
+
+	// count of one write is int, so nodes are written in pieces, number
+	// of pieces is same on every process (writes are collective)
+	size_t piece = MESSAGE_MAX_BYTES / sizeof(index_t);
+	long long pieces = (nodes.size() + piece - 1) / piece;
+	MPI_Allreduce(MPI_IN_PLACE,&pieces,1,MPI_LONG_LONG,MPI_MAX,MPI_COMM_WORLD);
+	int result = MPI_SUCCESS;
+	for (long long k = 0; k < pieces; k++) {
+		size_t begin = min(nodes.size(), (size_t) k * piece);
+		size_t end = min(nodes.size(), begin + piece);
+		MPI_Datatype view;
+		MPI_Type_create_hindexed_block(end - begin,1,displacements.data() + begin,MPI_INDEX,&view);
+		MPI_Type_commit(&view);
+		MPI_File_set_view(file,0,MPI_INDEX,view,"native",MPI_INFO_NULL);
+		if (MPI_File_write_at_all(file,0,nodes.data() + begin,end - begin,MPI_INDEX,MPI_STATUS_IGNORE) != MPI_SUCCESS) {
+			result = MPI_ERR_OTHER;
+		}
+		MPI_Type_free(&view);
+	}
+	MPI_File_close(&file);
+	if (result != MPI_SUCCESS) {
+		throw "Cannot write output file";
+	}
+}
+
+void forest_print(const Tree &tree, const vector<index_t> &positions) {
+	// trees are placed one after another in order of their roots,
+	// root of tree is first in its part of result
+	const vector<index_t> &roots = tree.get_roots();
+	vector<index_t> root_of = tree.root_of();
+	vector<index_t> tree_size(tree.get_node_count(), 0);
+	for (index_t node = 0; node < tree.get_node_count(); node++) {
+		tree_size[root_of[node]]++;
+	}
+	vector<index_t> offset(tree.get_node_count(), 0);
+	vector<index_t> result(tree.get_node_count());
+	index_t total = 0;
+	for (index_t i = 0; i < roots.size(); i++) {
+		offset[roots[i]] = total;
+		result[total] = roots[i];
+		total += tree_size[roots[i]];
+	}
+
+	// node is placed by suffix sum of edge going into it in its tree
+	for (index_t i = 0; i < positions.size(); i += 2) {
+		index_t node = tree.slot_node(utility::heap_edge_child(positions[i]));
+		index_t root = root_of[node];
+		result[offset[root] + utility::preorder(positions[i + 1], tree_size[root])] = node;
+	}
+	for (index_t i = 0; i < roots.size(); i++) {
+		index_t begin = offset[roots[i]];
+		tree.print(vector<index_t>(result.begin() + begin, result.begin() + begin + tree_size[roots[i]]));
+	}
+}
+
+bool Options::is_local() {
+	return this->sequential || !this->updates.empty() || (this->threads > 0 && !this->auto_engine && this->queries.empty());
+}
+
+int local_preorder(Options options) {
+	try {
+		if (options.error != NULL) {
+			throw options.error;
+		}
+		if (options.forest) {
+			throw "Forest is ranked only by MPI processes";
+		}
+		if (!options.output.empty()) {
+			throw "Output file is written only by MPI processes";
+		}
+		if (!options.queries.empty()) {
+			throw "Queries are answered only by MPI processes";
+		}
+		Tree tree = options.input_file.empty() ? Tree(options.node_list) : Tree::read(options.input_file, options.input_format);
+		if (!options.updates.empty()) {
+			ifstream file;
+			if (options.updates != INPUT_STDIN) {
+				file.open(options.updates);
+				if (!file.is_open()) {
+					throw "Cannot open update file";
+				}
+			}
+			incremental_preorder(tree, options.updates == INPUT_STDIN ? cin : file);
+		} else if (options.sequential) {
+			sequential_preorder(tree);
+		} else {
+			thread_preorder(options, tree);
+		}
+	} catch (const char *error) {
+		fprintf(stderr, "%s\n", error);
+		return 1;
+	}
+	return 0;
+}
+
+int mpi_preorder(Options options, int rank, int size) {
+	// input tree (in form of array or read from file by main process)
+	Tree tree;
 	// variables for storing edge id and
 	// weight of each edge
 	int edge_id, weight;
 	// flag specifying if edge in process
 	// is forward or not
 	bool forward;
-	// variables for storing rank of processes
-	// and total number of processes
-	int rank, size;
 
-	// edge list stores every created edge
-	// used only by main
-	edge_list_t edge_list;
-	// stores lists of adj elems 
-	// (see more in constructor of Adj_elem)
-	// create by main, broadcast to every
-	// process
-	adj_t adj;
-	// list will contain name of nodes with its
-	// preorder position (used only by main)
-	node_list_t preorder_node_list;
-	
-	// MPI initialilzation
-	MPI_Init(&argc, &argv);
+	// store of edges, created by main,
+	// broadcast to every process
+	Edge_store edges;
 	MPI_Status status;
-	MPI_Comm_size(MPI_COMM_WORLD, &size);
-	MPI_Comm_rank(MPI_COMM_WORLD, &rank); 
-	
-	/**** CREATE ADJ LIST AND BROADCAST ****/
-	if (rank == PROC_MAIN) {
-		// firstly, check, if it is necessary to try to
-		// compute preorder sequence
-		if (node_list.length() == 1) {
-			printf("%c\n", node_list[0]);
-			MPI_Finalize();
-			return 0;
+
+	// invalid values of flags are found by parsing, before any input
+	if (options.error != NULL) {
+		if (rank == PROC_MAIN) {
+			fprintf(stderr, "%s\n", options.error);
 		}
-		// create edges and send them to correct processes
-		// NOTE: tree is indexed from 1
-		for (int i = 0; i < node_list.length(); i++) {
-			// create indexes specifying node childs and
-			// number of process, which will recieve edge
-			int left_index = (2 * (i + 1)) - 1;
-			int right_index = (2 * (i + 1));
-			vector<Adj_elem> adj_forward_node;
-			vector<Adj_elem> adj_reverse_node_left;
-			vector<Adj_elem> adj_reverse_node_right;
-			
-			if (left_index < node_list.length()) {
-				// create 2 edges
-				Edge forward = Edge(node_list[i], node_list[left_index]);
-				Edge reverse = Edge(node_list[left_index], node_list[i]);
-				// add edges to list of edges
-				edge_list.push_back(forward);
-				edge_list.push_back(reverse);
-				// create adj elem
-				Adj_elem forward_elem = Adj_elem(node_list[i], forward.get_id(), reverse.get_id(), true);
-				Adj_elem reverse_elem = Adj_elem(node_list[left_index], reverse.get_id(), forward.get_id(), false);
-				// push adj elem to adj for node
-				adj_forward_node.push_back(forward_elem);
-				adj_reverse_node_left.push_back(reverse_elem);
-			}
+		return 1;
+	}
 
-			if (right_index < node_list.length()) {
-				// create 2 edges
-				Edge forward = Edge(node_list[i], node_list[right_index]);
-				Edge reverse = Edge(node_list[right_index], node_list[i]);
-				// add edges to list of edges
-				edge_list.push_back(forward);
-				edge_list.push_back(reverse);
-				// create adj elem
-				Adj_elem forward_elem = Adj_elem(node_list[i], forward.get_id(), reverse.get_id(), true);
-				Adj_elem reverse_elem = Adj_elem(node_list[right_index], reverse.get_id(), forward.get_id(), false);
-				// push adj elem to adj for node
-				adj_forward_node.push_back(forward_elem);
-				adj_reverse_node_right.push_back(reverse_elem);
+	if (options.input_file.empty()) {
+		tree = options.forest ? Tree::forest(options.node_lists) : Tree(options.node_list);
+	} else if (options.parallel_input && !options.forest && options.queries.empty()) {
+		// every process reads its slice, so errors are same on every process
+		try {
+			tree = Tree::read_parallel(options.input_file, options.input_format, rank, size);
+		} catch (const char *error) {
+			if (rank == PROC_MAIN) {
+				fprintf(stderr, "%s\n", error);
+			}
+			return 1;
+		}
+	} else {
+		// error is broadcast, so every process returns
+		int failed = 0;
+		if (rank == PROC_MAIN) {
+			try {
+				tree = Tree::read(options.input_file, options.input_format, options.forest, options.mapped);
+			} catch (const char *error) {
+				fprintf(stderr, "%s\n", error);
+				failed = 1;
 			}
+		}
+		MPI_Bcast(&failed,1,MPI_INT,PROC_MAIN,MPI_COMM_WORLD);
+		if (failed) {
+			return 1;
+		}
+		tree.broadcast();
+	}
+	index_t node_count = tree.get_node_count();
 
-			if (!adj_forward_node.empty()) {
-				adj = utility::push_edge_vector(adj_forward_node, adj);
+	// engine is chosen by main process, which holds whole tree
+	// (other engines rank only single tree)
+	if (options.auto_engine && !options.forest && options.output.empty() && options.queries.empty() && !tree.is_distributed() && options.numbers.empty() && node_count > 1) {
+		Profile::phase("SELECT ENGINE");
+		int engine = select_engine(options, node_count, rank, size);
+		if (engine != ENGINE_DISTRIBUTED) {
+			if (rank == PROC_MAIN) {
+				if (engine == ENGINE_SEQUENTIAL) {
+					sequential_preorder(tree);
+				} else {
+					options.threads = options.threads > 0 ? options.threads : max(1, (int) thread::hardware_concurrency());
+					thread_preorder(options, tree);
+				}
 			}
+			return 0;
+		}
+	}
 
-			if (!adj_reverse_node_left.empty()) {
-				adj = utility::push_edge_vector(adj_reverse_node_left, adj);
+	// queries are answered by index built from tree numbers
+	if (!options.queries.empty()) {
+		try {
+			if (options.forest) {
+				throw "Queries are not supported for forest";
+			}
+			block_lca_queries(options, tree, rank, size);
+		} catch (const char *error) {
+			if (rank == PROC_MAIN) {
+				fprintf(stderr, "%s\n", error);
 			}
+			return 1;
+		}
+		return 0;
+	}
 
-			if (!adj_reverse_node_right.empty()) {
-				adj = utility::push_edge_vector(adj_reverse_node_right, adj);
+	// tree numbers are counted only in block mode
+	if (!options.numbers.empty()) {
+		try {
+			if (options.forest) {
+				throw "Tree numbers are not supported for forest";
+			}
+			if (!options.output.empty()) {
+				throw "Tree numbers cannot be written to output file";
 			}
+			block_tree_numbers(options, tree, rank, size);
+		} catch (const char *error) {
+			if (rank == PROC_MAIN) {
+				fprintf(stderr, "%s\n", error);
+			}
+			return 1;
 		}
+		return 0;
+	}
 
-		// send id of edges to processes (not to process 0, which is main)
-		for (int i = 0; i < edge_list.size(); i++) {
-			int edge_id = edge_list[i].get_id();
-			MPI_Send(&edge_id,1,MPI_INT,edge_id,EDGE_ID,MPI_COMM_WORLD);
+	// positions in forest are known only by main process
+	if (options.forest && !options.output.empty()) {
+		if (rank == PROC_MAIN) {
+			fprintf(stderr, "Forest cannot be written to output file\n");
 		}
+		return 1;
+	}
 
-		// broadcast number of lists for each node
-		int node_list_num = adj.size();
-		for (int i = 1; i < size; i++) {
-			MPI_Send(&node_list_num,1,MPI_INT,i,NODE_LIST_NUM,MPI_COMM_WORLD);
+	// ruling set expects only one list, tours of forest are separate lists
+	if (options.forest && options.ruling_set) {
+		if (rank == PROC_MAIN) {
+			fprintf(stderr, "Forest cannot be ranked by ruling set\n");
 		}
+		return 1;
+	}
 
-		// iterate over lists for each node
-		//adj_t adj;
-		for (int i = 0; i < node_list_num; i++) {
-			// broadcast number of adj elems
-			int adj_elem_num = adj[i].size();
-			for (int j = 1; j < size; j++) {
-				MPI_Send(&adj_elem_num,1,MPI_INT,j,NODE_ADJ_NUM,MPI_COMM_WORLD);
+	// tree with only root (or forest of roots) has no edges
+	const vector<index_t> &roots = tree.get_roots();
+	if (node_count == roots.size() && !options.output.empty()) {
+		try {
+			write_preorder(options.output, tree, vector<index_t>(), rank);
+		} catch (const char *error) {
+			if (rank == PROC_MAIN) {
+				fprintf(stderr, "%s\n", error);
 			}
-			// iterate over adj elems
-			for (int j = 0; j < adj_elem_num; j++) {
-				// broadcast adj elems (aka forward and reverse)
-				for (int k = 1; k < size; k++) {
-					char node_id = adj[i][j].get_node_id();
-					int forward_id = adj[i][j].get_forward_id();
-					int reverse_id = adj[i][j].get_reverse_id();
-					int inserted_as_forward = adj[i][j].is_forward_elem();
-					MPI_Send(&node_id,1,MPI_CHAR,k,ADJ_NODE,MPI_COMM_WORLD);
-					MPI_Send(&forward_id,1,MPI_INT,k,ADJ_FORWARD,MPI_COMM_WORLD);
-					MPI_Send(&reverse_id,1,MPI_INT,k,ADJ_REVERSE,MPI_COMM_WORLD);
-					MPI_Send(&inserted_as_forward,1,MPI_C_BOOL,k,ADJ_BOOL,MPI_COMM_WORLD);
-				}
+			return 1;
+		}
+		return 0;
+	} else if (node_count == roots.size()) {
+		if (rank == PROC_MAIN) {
+			for (size_t i = 0; i < roots.size(); i++) {
+				tree.print(vector<index_t>(1, roots[i]));
 			}
 		}
-	} else {
-		// recieve id of edge
-		MPI_Recv(&edge_id,1,MPI_INT,PROC_MAIN,EDGE_ID,MPI_COMM_WORLD,&status);
-		// recieve number of lists in adj
-		int node_list_num;
-		MPI_Recv(&node_list_num,1,MPI_INT,PROC_MAIN,NODE_LIST_NUM,MPI_COMM_WORLD,&status);
-
-		// iterate over recieving lists for each node
-		for (int i = 0; i < node_list_num; i++) {
-			vector<Adj_elem> adj_for_node;
-
-			// recieve number of adj elems
-			int adj_elem_num;
-			MPI_Recv(&adj_elem_num,1,MPI_INT,PROC_MAIN,NODE_ADJ_NUM,MPI_COMM_WORLD,&status);
-
-			// iterate over adj elems
-			for (int j = 0; j < adj_elem_num; j++) {
-				// recieve adj elems (aka forward and reverse)
-				char node_id;
-				int forward_id;
-				int reverse_id;
-				bool inserted_as_forward;
-				MPI_Recv(&node_id,1,MPI_CHAR,PROC_MAIN,ADJ_NODE,MPI_COMM_WORLD,&status);
-				MPI_Recv(&forward_id,1,MPI_INT,PROC_MAIN,ADJ_FORWARD,MPI_COMM_WORLD,&status);
-				MPI_Recv(&reverse_id,1,MPI_INT,PROC_MAIN,ADJ_REVERSE,MPI_COMM_WORLD,&status);
-				MPI_Recv(&inserted_as_forward,1,MPI_C_BOOL,PROC_MAIN,ADJ_BOOL,MPI_COMM_WORLD,&status);
-				Adj_elem adj_elem = Adj_elem(node_id, forward_id, reverse_id, inserted_as_forward);
-				adj_for_node.push_back(adj_elem);
+		return 0;
+	}
+
+	// each edge needs its own process, if there is not exactly
+	// one process per edge (or tree is distributed or forest or
+	// blocks are placed or adj list is mapped or result is written
+	// to file), then edges are distributed in blocks
+	if (options.block || options.forest || options.placement || !options.mapped.empty() || !options.output.empty()
+			|| tree.is_distributed() || size != 2 * (node_count - 1) + 1) {
+		try {
+			block_preorder(options, tree, rank, size);
+		} catch (const char *error) {
+			if (rank == PROC_MAIN) {
+				fprintf(stderr, "%s\n", error);
 			}
-			adj = utility::push_edge_vector(adj_for_node, adj);
+			return 1;
 		}
+		return 0;
+	}
+	
+	/**** CREATE ADJ LIST AND BROADCAST ****/
+	Profile::phase("CREATE ADJ LIST AND BROADCAST");
+	// ids of edges do not depend on order of creation, so every process
+	// knows its edge from its rank (aka edge id) without any message
+	edge_id = rank;
+	if (options.adjacency) {
+		if (rank == PROC_MAIN) {
+			edges = Edge_store(tree);
+		}
+		edges.broadcast(rank);
 	}
 
 	/**** EULER TOUR ****/
-	// count euler tour only by non-main edges
+	Profile::phase("EULER TOUR");
+	// euler tour starts by first edge of root
+	int head = options.adjacency ? edges.get_head() : 1;
+	// count euler tour only by non-main edges, both forms already
+	// contain fixed ending edge
 	int euler_next;
-	vector<int> euler_tour;
 	if (rank != PROC_MAIN) {
-		// count id of next edge in euler tour
-		euler_next = utility::euler_tour(edge_id, adj);
-		// send next edge id to main process
-		MPI_Send(&euler_next,1,MPI_INT,PROC_MAIN,EULER_TOUR,MPI_COMM_WORLD);
-	} else {
-		// recieve euler next edge from every process and create euler tour list
-		for (int i = 1; i < size; i++) {
-			MPI_Recv(&euler_next,1,MPI_INT,i,EULER_TOUR,MPI_COMM_WORLD,&status);
-			euler_tour.push_back(euler_next);
-		}
-		// fix euler tour (last edge to root pointing to itself)
-		euler_tour = utility::fix_euler_tour(euler_tour, edge_list, node_list[0]);
-	}
-	if (rank == PROC_MAIN) {
-		// send edges to processes in order of euler tour
-		for (int i = 0; i < euler_tour.size(); i++) {
-			MPI_Send(&euler_tour[i],1,MPI_INT,i+1,EULER_TOUR_FIXED,MPI_COMM_WORLD);
+		if (options.adjacency) {
+			euler_next = utility::euler_tour(edge_id, edges);
+		} else {
+			euler_next = utility::heap_euler_tour(edge_id, node_count);
 		}
-	} else {
-		// recieve next edge in euler tour 
-		// note that only for 1 process there is change
-		MPI_Recv(&euler_next,1,MPI_INT,PROC_MAIN,EULER_TOUR_FIXED,MPI_COMM_WORLD,&status);
 	}
 
 	/**** SET WEIGHTS ****/
+	Profile::phase("SET WEIGHTS");
 	// weight is defined only for non-main processes (holding edges)
 	// also, save forward info for later, it is used in counting the
 	// preorder node position and it should be more effective to save it
 	// than to search for this property
 	if (rank != PROC_MAIN) {
-		if (utility::is_forward(edge_id, adj)) {
+		if (options.adjacency ? utility::is_forward(edge_id, edges) : utility::heap_is_forward(edge_id)) {
 			weight = 1;
 			forward = true;
 		} else {
@@ -278,144 +1302,160 @@ int main(int argc, char** argv) {
 	}
 
 	/**** SUM OF SUFFIX ****/
-	if (rank != PROC_MAIN) {
+	Profile::phase("SUM OF SUFFIX");
+	if (options.rma || options.ruling_set) {
+		// every process (except main) holds block of one edge, so
+		// main process is not needed as coordinator of rounds
+		Edge_block block = Edge_block(size - 1, size, 1);
+		vector<index_t> weights, euler_nexts;
+		if (rank != PROC_MAIN) {
+			weights.push_back(weight);
+			euler_nexts.push_back(euler_next);
+		}
+		if (options.ruling_set) {
+			ruling_set_suffix_sum(weights, euler_nexts, block, rank, head);
+		} else {
+			rma_suffix_sum(weights, euler_nexts, block, rank);
+		}
+		if (rank != PROC_MAIN) {
+			weight = weights[0];
+			euler_next = euler_nexts[0];
+		}
+	} else if (options.nonblocking) {
+		if (rank != PROC_MAIN) {
+			int ending_edge = options.adjacency ? edges.get_ending_edge() : utility::heap_ending_edge(node_count);
+			nonblocking_suffix_sum(weight, euler_next, edge_id, head, ending_edge);
+		}
+	} else {
 		// defaultly, only first process is sleeping (no process will notice first process)
-		bool sleeping = false || edge_id == 1;
-		bool ending_edge = euler_next == edge_id;
-		// last process must be able to answer more than 1 noticing
-		// number of notice messages is counted as:
-		// ending_edge_noticing_sum = min(((ending_edge_noticing_sum * 2) - 1), size - 1)
-		int ending_edge_noticing_sum = STARTING_ENDING_EDGE_NOTICING_SUM;
+		bool sleeping = rank == PROC_MAIN || edge_id == head;
+		// finished edge knows its whole suffix sum, so it points to itself
+		// and its predecessor finishes after reading it, so no edge is
+		// noticed by more than one process in a round (edge going to
+		// ending edge would else be noticed by more and more processes)
+		bool finished = rank == PROC_MAIN || euler_next == edge_id;
 
 		// set neutral element
-		if (ending_edge) {
+		if (rank != PROC_MAIN && euler_next == edge_id) {
 			weight = 0;
 		}
 
-		for (int i = 0; i <= ceil(log((double) size)); i++) {
+		vector<int> next_edges(rank == PROC_MAIN ? size : 0);
+		vector<int> states(rank == PROC_MAIN ? size : 0);
+		// rounds run until every edge is finished (instead of fixed
+		// number of rounds), so short lists finish in fewer rounds
+		int state = ROUND_AWAKE;
+		while (state != ROUND_STOP) {
+			Profile::round();
 			// notice process defined by euler_next that actual process
 			// wants his value of weight and euler_next
-			// note that ending process should not perform noticing
-			MPI_Send(&rank,1,MPI_INT,euler_next,VALUES_WANTED,MPI_COMM_WORLD);
+			if (!finished) {
+				MPI_Send(&rank,1,MPI_INT,euler_next,VALUES_WANTED,MPI_COMM_WORLD);
+			}
 			// noticed can be only non-sleeping processes
 			// first process cannot be noticed (it has no predcessor)
-			// ending edge must handle noticing from more than 1 process
-			if (!sleeping && !ending_edge) {
-				// recieve info fromm process that it wanted 
+			if (!sleeping) {
+				// recieve info fromm process that it wanted
 				int notice_process_id;
 				MPI_Recv(&notice_process_id,1,MPI_INT,MPI_ANY_SOURCE,VALUES_WANTED,MPI_COMM_WORLD,&status);
 				// send wanted info
 				MPI_Send(&weight,1,MPI_INT,notice_process_id,VALUES_WEIGHT,MPI_COMM_WORLD);
 				MPI_Send(&euler_next,1,MPI_INT,notice_process_id,VALUES_NEXT_EDGE,MPI_COMM_WORLD);
-
 			}
-			// handling noticing of last process
-			if (!sleeping && ending_edge) {
-				for (int j = 0; j < ending_edge_noticing_sum; j++) {
-					// recieve info fromm process that it wanted 
-					int notice_process_id;
-					MPI_Recv(&notice_process_id,1,MPI_INT,MPI_ANY_SOURCE,VALUES_WANTED,MPI_COMM_WORLD,&status);
-					// send wanted info
-					MPI_Send(&weight,1,MPI_INT,notice_process_id,VALUES_WEIGHT,MPI_COMM_WORLD);
-					MPI_Send(&euler_next,1,MPI_INT,notice_process_id,VALUES_NEXT_EDGE,MPI_COMM_WORLD);
+
+			// recieve new values from euler_next process, values are
+			// updated after answering, so there is no RAW conflict
+			if (!finished) {
+				int recieved_weight;
+				int recieved_euler_next;
+				MPI_Recv(&recieved_euler_next,1,MPI_INT,euler_next,VALUES_NEXT_EDGE,MPI_COMM_WORLD,&status);
+				MPI_Recv(&recieved_weight,1,MPI_INT,euler_next,VALUES_WEIGHT,MPI_COMM_WORLD,&status);
+				weight = weight + recieved_weight;
+				// successor pointing to itself was finished
+				if (recieved_euler_next == euler_next) {
+					finished = true;
+					euler_next = edge_id;
+				} else {
+					euler_next = recieved_euler_next;
 				}
-				ending_edge_noticing_sum = utility::update_ending_edge_noticing_sum(ending_edge_noticing_sum, size);
 			}
 
-			// recieve new values from euler_next process
-			int recieved_weight;
-			int recieved_euler_next;
-			MPI_Recv(&recieved_euler_next,1,MPI_INT,euler_next,VALUES_NEXT_EDGE,MPI_COMM_WORLD,&status);
-			MPI_Recv(&recieved_weight,1,MPI_INT,euler_next,VALUES_WEIGHT,MPI_COMM_WORLD,&status);
-			
-			// send to main process new successor - main will inform that successor process, that it
-			// cannot go to sleep, because there will be at least one process (calling process), 
-			// which will send noticing to the successor process
-			bool recieved_sleeping;
-			MPI_Send(&recieved_euler_next,1,MPI_INT,PROC_MAIN,RECIEVED_EULER_NEXT,MPI_COMM_WORLD);
-			MPI_Recv(&recieved_sleeping,1,MPI_C_BOOL,PROC_MAIN,VALUES_SLEEPING,MPI_COMM_WORLD,&status);
-
 			/**** BARRIER ****/
-			// all process must wait until every process has send and recieved new values
-			// to handle RAW conflict, this is implemented as waiting to info about sleeping,
-			// because main process sends this info after every process sends to main its 
-			// next edge id, else main process waits and so waits other processes
-
-			// update weight, identificator of next edge (and process) and if process should be sleeping
-			weight = weight + recieved_weight;
-			euler_next = recieved_euler_next;
-			sleeping = recieved_sleeping;
-		}
-		// note, that correction is not needed due to behaviour of suffix sum algorithm for adding
-
-	} else {
-		// main process must answer in same duration as other processes sends data
-		for (int i = 0; i <= ceil(log((double) size)); i++) {
-			// accept from each process info about new successor and saves those references
-			vector<int> next_active_processes;
-			int recieved_id;
-			for (int i = 1; i < size; i++) {
-				MPI_Recv(&recieved_id,1,MPI_INT,i,RECIEVED_EULER_NEXT,MPI_COMM_WORLD,&status);
-				next_active_processes.push_back(recieved_id);
-			}
-			// after recieving new successors references, send to processes, which id is in
-			// net_active_processes, stay alive info, to others send go to sleep info
-			bool stay_alive = false;
-			bool go_to_sleep = true;
-			// iterate over every processor id (except PROC_MAIN)
-			for (int i = 1; i < size; i++) {
-				if (find(next_active_processes.begin(), next_active_processes.end(), i) != next_active_processes.end()) {
-					// if reference of id of process is in next_active_processes, then this process should be awake
-					MPI_Send(&stay_alive,1,MPI_C_BOOL,i,VALUES_SLEEPING,MPI_COMM_WORLD);
-				} else {
-					// if nobody will notice processor od id == i, then it can go sleep
-					MPI_Send(&go_to_sleep,1,MPI_C_BOOL,i,VALUES_SLEEPING,MPI_COMM_WORLD);
+			// main process gathers successors of unfinished edges, edges
+			// which are successors of nobody can go to sleep and if every
+			// edge is finished, rounds stop (flag is part of state),
+			// collectives also separate rounds (so there is no RAW conflict)
+			int next_edge = finished ? NO_EDGE : euler_next;
+			MPI_Gather(&next_edge,1,MPI_INT,next_edges.data(),1,MPI_INT,PROC_MAIN,MPI_COMM_WORLD);
+			if (rank == PROC_MAIN) {
+				bool stop = count(next_edges.begin(), next_edges.end(), NO_EDGE) == size;
+				fill(states.begin(), states.end(), stop ? ROUND_STOP : ROUND_SLEEPING);
+				for (int j = 0; j < size && !stop; j++) {
+					states[next_edges[j]] = ROUND_AWAKE;
 				}
-			} 
+			}
+			MPI_Scatter(states.data(),1,MPI_INT,&state,1,MPI_INT,PROC_MAIN,MPI_COMM_WORLD);
+			sleeping = rank == PROC_MAIN || state != ROUND_AWAKE;
 		}
+		// note, that correction is not needed due to behaviour of suffix sum algorithm for adding
 	}
 
 	/**** PREORDER ****/
-	// preorder position is counted only by non-main processes
-	int preorder_position;
-	if (rank != PROC_MAIN) {
-		// preorder position is counted only for forward edges
-		if (forward) {
-			preorder_position = utility::preorder(weight, node_list.length());
-			MPI_Send(&preorder_position,1,MPI_INT,PROC_MAIN,PREORDER,MPI_COMM_WORLD);
-		}
-	} else {
-		// recieve edges
-		for (int i = 0; i < node_list.length() - 1; i++) {
-			int preorder_position;
-			int edge_id;
-			// recieve id of process (and edge in same time)
-			MPI_Recv(&preorder_position,1,MPI_INT,MPI_ANY_SOURCE,PREORDER,MPI_COMM_WORLD,&status);
-			edge_id = status.MPI_SOURCE;
-			// search in list of edges for edge specified by given id (of processor == i)
-			for (int j = 0; j < edge_list.size(); j++) {
-				if (edge_list[j].get_id() == edge_id) {
-					Nodes node = Nodes(preorder_position, edge_list[j].get_end_node());
-					preorder_node_list.push_back(node);
-				}
-			}
-		}
+	Profile::phase("PREORDER");
+	// every process sends pair (preorder position, end node) of its edge,
+	// main process and reverse edges send (-1, -1), so result is gathered
+	// by one collective instead of message per edge
+	int position[2] = {-1, -1};
+	if (rank != PROC_MAIN && forward) {
+		position[0] = utility::preorder(weight, node_count);
+		// end node of edge is known from its id (see Tree::edge_slot)
+		position[1] = tree.slot_node(utility::heap_edge_child(edge_id));
 	}
+	vector<int> all_positions(rank == PROC_MAIN ? 2 * size : 0);
+	MPI_Gather(position,2,MPI_INT,all_positions.data(),2,MPI_INT,PROC_MAIN,MPI_COMM_WORLD);
 
 	/**** PRINT RESULT ****/
+	Profile::phase("PRINT RESULT");
 	if (rank == PROC_MAIN) {
-		// firstly, print root in position 1
-		printf("%c", node_list[0]);
-		for (int i = 1; i <= node_list.length(); i++) {
-			for (int j = 0; j < preorder_node_list.size(); j++) {
-				if (preorder_node_list[j].get_preorder_position() == i) {
-					printf("%c", preorder_node_list[j].get_node_name());
-					break;
-				}
+		// root is in position 0, other nodes are placed directly by their position
+		vector<index_t> result(node_count);
+		result[0] = tree.get_root();
+		for (int i = 0; i < 2 * size; i += 2) {
+			if (all_positions[i] >= 0) {
+				result[all_positions[i]] = all_positions[i + 1];
 			}
 		}
-		cout << endl;
+		tree.print(result);
+	}
+	return 0;
+}
+
+int main(int argc, char** argv) {
+	// first at all, check, if there is any argument
+	Options options = Options(argc, argv);
+	if (options.node_list.empty() && options.input_file.empty() && options.serve.empty()) {
+		return 0;
+	}
+
+	// sequential, incremental and shared memory backends run without MPI
+	// (with -e, number of threads only limits chosen engine)
+	if (options.serve.empty() && options.is_local()) {
+		return local_preorder(options);
+	}
+
+	// variables for storing rank of processes
+	// and total number of processes
+	int rank, size;
+
+	// MPI initialilzation
+	MPI_Init(&argc, &argv);
+	MPI_Comm_size(MPI_COMM_WORLD, &size);
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank); 
+	if (!options.profile.empty()) {
+		Profile::enable(options.profile);
 	}
 
+	int result = options.serve.empty() ? mpi_preorder(options, rank, size) : serve(options, rank, size);
 	MPI_Finalize();
+	return result;
 }
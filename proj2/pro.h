@@ -8,139 +8,378 @@
 #define PRO_H
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <mpi.h>
 #include <string>
 #include <vector>
 #include <utility>
 #include <math.h>
 #include <algorithm>
+#include <cstddef>
+#include <climits>
+#include <limits>
+#include <memory>
+#include "tree.h"
 
 // rank of main process
 #define PROC_MAIN 0
 
 // mpi tags
-#define EDGE_ID 0
-#define NODE_LIST_NUM 1
-#define NODE_ADJ_NUM 2
-#define ADJ_FORWARD 3
-#define ADJ_REVERSE 4
-#define ADJ_NODE 5
-#define EULER_TOUR 6
-#define ADJ_BOOL 7
-#define EULER_TOUR_FIXED 8
 #define VALUES_WANTED 9
 #define VALUES_WEIGHT 10
 #define VALUES_NEXT_EDGE 11
-#define RECIEVED_EULER_NEXT 12
-#define VALUES_SLEEPING 13
-#define PREORDER 14
+#define EULER_PREDECESSOR 15
+#define VALUES_PACKED 16
+#define VALUES_PREDECESSOR 17
+#define VALUES_PIECE 18
 
-#define STARTING_ENDING_EDGE_NOTICING_SUM 2
+// id of missing edge (edges have ids from 1)
+#define NO_EDGE 0
+
+// suffixes of scratch files created next to file given by -x
+#define SCRATCH_FIRST ".first"
+#define SCRATCH_EDGES ".edges"
+#define SCRATCH_POSITION ".position"
+#define SCRATCH_ORDER ".order"
+
+// states of process in round of suffix sum (sent by main process)
+#define ROUND_AWAKE 0
+#define ROUND_SLEEPING 1
+#define ROUND_STOP 2
+
+// command line flags
+#define FLAG_BLOCK "-b"
+#define FLAG_ADJACENCY "-a"
+#define FLAG_RMA "-r"
+#define FLAG_RULING_SET "-l"
+#define FLAG_THREADS "-t"
+#define FLAG_INPUT "-i"
+#define FLAG_FORMAT "-f"
+#define FLAG_NUMBERS "-c"
+#define FLAG_PROFILE "-p"
+#define FLAG_NONBLOCKING "-n"
+#define FLAG_PARALLEL_INPUT "-m"
+#define FLAG_SEQUENTIAL "-s"
+#define FLAG_AUTO_ENGINE "-e"
+#define FLAG_COST_PROFILE "-k"
+#define FLAG_UPDATES "-u"
+#define FLAG_SERVE "-d"
+#define FLAG_FOREST "-o"
+#define FLAG_PLACEMENT "-g"
+#define FLAG_MAPPED "-x"
+#define FLAG_OUTPUT "-w"
+#define FLAG_QUERIES "-q"
+
+// on average every RULING_SET_STRIDE-th edge is chosen as splitter
+// (multiplied by binary log of number of edges)
+#define RULING_SET_STRIDE 1
 
 using namespace std;
 
+// pool of threads of shared memory backend (see threads.h)
+class Thread_pool;
+
 /**
- * Class instances encapsulates data of one edge
+ * Class describes distribution of edges into contiguous blocks
  *
- * each edge is represented by 2 chars (start and end node
- * of edge) and generated id
+ * edges (with ids 1..edge_count) are split into blocks of nearly same
+ * size, process with rank r owns ids first(r)..first(r) + count(r) - 1
+ *
+ * processes with rank lower than first_rank own no edges, so with
+ * first_rank 1 and size - 1 edges, process with rank r owns edge r
+ * (which is layout of mode with one process per edge)
+ *
+ * blocks can be placed to processes in other order (see place_blocks),
+ * then process with rank r owns block with index placement[r]
  */
-class Edge {
+class Edge_block {
 	private:
-		int id;
-		char start_node;
-		char end_node;
-		static int id_counter;
-		int preorder_position;
+		index_t edge_count;
+		int size;
+		int first_rank;
+		vector<int> placement;
+		vector<int> holder;
+
+		/**
+		 * Method returns first edge id of block
+		 * @param index index of block (rank of its owner without placement)
+		 * @return id of first edge in block
+		 */
+		index_t start(int index);
 	public:
 		/**
-		 * Getter of edge id
-		 * @return id of edge object
+		 * Constructor of edge block object
+		 * @param edge_count total number of edges
+		 * @param size total number of processes
+		 * @param first_rank rank of first process owning edges
+		 */
+		Edge_block(index_t edge_count, int size, int first_rank = 0);
+
+		/**
+		 * Method returns first edge id owned by process
+		 * @param rank rank of process
+		 * @return id of first edge in block of process
+		 */
+		index_t first(int rank);
+
+		/**
+		 * Method returns number of edges owned by process
+		 * @param rank rank of process
+		 * @return number of edges in block of process (may be 0)
+		 */
+		index_t count(int rank);
+
+		/**
+		 * Method returns rank of process owning given edge
+		 * @param edge_id id of edge
+		 * @return rank of process, which block contains edge
+		 */
+		int owner(index_t edge_id);
+
+		/**
+		 * Method returns index of edge in local arrays of its owner
+		 * @param edge_id id of edge
+		 * @return index of edge inside block of its owner
 		 */
-		int get_id();
+		index_t local_index(index_t edge_id);
 
 		/**
-		 * Getter of start node
-		 * @return name (char) of node from which edge is starting
+		 * Method places blocks to processes
+		 * @param placement index of block owned by every process
 		 */
-		char get_start_node();
+		void place(vector<int> placement);
+};
+
+/**
+ * Class holds settings given on command line
+ *
+ * usage: pro [-b] [-a] [-g] [-x FILE] [-r | -l | -n] [-s | -t N | -e [-k FILE] | -u FILE] [-c NUMBERS | -w FILE | -q FILE] [-p FILE] (SEQUENCE | -i FILE [-f FORMAT] [-m])
+ *        pro -o [-g] [-r] [-p FILE] (SEQUENCE... | -i FILE [-f FORMAT])
+ *        pro -d SOCKET [-p FILE]
+ *   -b  block mode, every process owns block of edges, so number
+ *       of processes does not depend on size of tree (used also
+ *       when number of processes does not match 2 * n - 1)
+ *   -a  build and broadcast adj list, without this flag euler tour
+ *       is derived from implicit heap order of sequence
+ *   -r  count suffix sum by one-sided communication (MPI_Get) instead
+ *       of messages, so no process coordinates rounds
+ *   -l  count suffix sum by work-efficient list ranking (ruling set)
+ *       instead of pointer jumping (not for forest, its tours are
+ *       separate lists)
+ *   -n  count suffix sum with one process per edge by nonblocking
+ *       messages, each round is one exchange with neighbours in list
+ *       without main process (block mode uses collectives anyway)
+ *   -s  run sequential DFS (MPI is not initialized)
+ *   -t N  run N threads in shared memory instead of MPI processes
+ *       (program is started without mpirun, MPI is not initialized)
+ *   -e  choose sequential DFS, threads (N given by -t or number of
+ *       cores) or MPI processes by cost model, costs are measured on
+ *       first run and cached (see cost_cache_file), trees smaller than
+ *       CALIBRATION_MIN_NODES use default costs
+ *   -k FILE  load costs of -e from file instead of cache, if file
+ *       cannot be loaded, measured costs are stored to it
+ *   -u FILE  print preorder and keep it updated by leaf insertions and
+ *       deletions read from file (- for standard input), see
+ *       incremental_preorder (MPI is not initialized)
+ *   -i FILE  read tree from file (- for standard input) instead of
+ *       SEQUENCE, nodes are identified by integer ids (see Tree)
+ *   -f FORMAT  format of input file (parents, edges, parents-bin,
+ *       edges-bin, parents-bin64, edges-bin64), default is parents
+ *   -m  every process reads its slice of input file by MPI-IO and
+ *       builds only edges in its block (parents-bin or parents-bin64
+ *       only, block mode)
+ *   -c NUMBERS  instead of preorder, print comma separated tree numbers
+ *       (pre, post, depth, size, desc) of every node, all of them are
+ *       counted in one suffix sum in block mode
+ *   -w FILE  instead of printing, every process writes ids of nodes
+ *       it placed to binary FILE (index_t integers, 64-bit unless built
+ *       with INDEX32, node in preorder position p at offset
+ *       p * sizeof(index_t)) by collective MPI-IO (block mode)
+ *   -q FILE  instead of preorder, answer lowest common ancestor and
+ *       ancestor queries of FILE (- for standard input) by index built
+ *       from tree numbers (threads building index given by -t, see
+ *       lca_queries)
+ *   -p FILE  write time, messages, bytes and suffix sum rounds of every
+ *       phase and process as JSON (- for standard output after result),
+ *       ignored with -t
+ *   -g  place blocks of edges to processes by topology of machine, so
+ *       blocks linked by many tour edges share node (block mode, see
+ *       place_blocks)
+ *   -x FILE  adj list is written to mapped FILE by main process and
+ *       mapped by other processes instead of broadcast, so process
+ *       loads only pages of its block (FILE must be visible to every
+ *       process, block mode), main process also keeps parent array
+ *       and temporary arrays of adj list in scratch files next to FILE
+ *       and preorder is written to scratch file and printed from it,
+ *       so no array of size of tree is allocated, only arrays of block
+ *       (O(n/p) per process) and reduced list of -l (O(n/log n) per
+ *       process)
+ *       stay in memory, results of -o, -c and -q are still gathered
+ *       to main process
+ *   -o  forest mode, every SEQUENCE is separate tree (or file has more
+ *       roots), tours of all trees are ranked by one suffix sum in
+ *       block mode and preorder of every tree is printed on its own
+ *       line (ordered by ids of roots)
+ *   -d SOCKET  keep processes running and answer queries sent to UNIX
+ *       socket, every query is line with arguments above (see serve)
+ */
+class Options {
+	public:
+		bool block;
+		bool adjacency;
+		bool rma;
+		bool ruling_set;
+		bool nonblocking;
+		int threads;
+		bool sequential;
+		bool auto_engine;
+		string cost_profile;
+		string updates;
+		string serve;
+		string node_list;
+		vector<string> node_lists;
+		bool forest;
+		bool placement;
+		string mapped;
+		string output;
+		string queries;
+		string input_file;
+		string input_format;
+		bool parallel_input;
+		string numbers;
+		string profile;
+		// invalid value of flag found by parsing (NULL if there is none)
+		const char *error;
 
 		/**
-		 * Getter of end node
-		 * @return name (char) of node in which edge is ending
+		 * Constructor parses command line arguments, invalid list of
+		 * tree numbers is reported by error
+		 * @param argc number of arguments
+		 * @param argv arguments given to program
 		 */
-		char get_end_node();
+		Options(int argc, char** argv);
 
 		/**
-		 * Constructor of edge object
-		 * @param start_node node from which edge is starting
-		 * @param end_node node in which edge is ending
+		 * Method checks, if chosen backend runs without MPI
+		 * @return true for sequential, incremental and shared memory backends
 		 */
-		Edge(char start_node, char end_node);
+		bool is_local();
 };
 
 /**
- * class implements container of forward and reverse 
- * edges (represented by id) stored in adj list
+ * Class implements store of edges as structure of arrays
+ *
+ * ids of edges are given by slots of their child nodes (forward edge
+ * into node in slot s has id 2s - 1 and reverse edge has id 2s, see
+ * Tree::edge_slot), so they do not depend on order of creation, arrays
+ * are indexed by edge id (index 0 is unused)
+ *
+ * adj list of node contains edge to parent first and then edges to
+ * children in order of their ids, euler successor of edge is edge
+ * following its reverse edge in adj list, last edge going to root
+ * (aka ending edge) is its own successor
+ *
+ * only targets and successors are stored (reverse id and direction
+ * follow from parity of id, source is target of reverse edge), both
+ * arrays are in memory or in file mapped by every process, so process
+ * holds only pages of edges it reads (see allocate), arrays used
+ * only while building store are then mapped scratch files too
  */
-class Adj_elem {
+class Edge_store {
 	private:
-		int forward_id;
-		int reverse_id;
-		char node_id;
-		bool inserted_as_forward;
+		index_t edge_count;
+		index_t head;
+		index_t ending_edge;
+		Mapped_array<index_t> storage;
+		index_t *target;
+		index_t *euler_next;
+
+		/**
+		 * Method allocates arrays of targets and successors
+		 * @param map_file path of file mapped as arrays (empty for memory)
+		 * @param create true for creating file (writable), false for
+		 *		mapping file created by main process (read only)
+		 */
+		void allocate(string map_file, bool create);
 	public:
 		/**
-		 * Constructor of adj elem object
-		 * @param node_id name of node from which forward edge is going
-		 * @param forward_id id of edge in forward direction
-		 * @param reverse_id id of edge in reverse direction
-		 * @param inserted_as_forward flag is true, if edge on forward place is trully forward
+		 * Constructor of empty store (filled by broadcast)
 		 */
-		Adj_elem(char node_id, int forward_id, int reverse_id, bool inserted_as_forward);
+		Edge_store();
 
 		/**
-		 * Method returns id of forward edge
-		 * @return id of edge in forward direction
+		 * Constructor builds edges and euler tour of tree
+		 * @param tree input tree
+		 * @param map_file path of file for arrays (empty for memory)
+		 * @param pool threads building store (NULL for calling thread
+		 *		only), forward edges are placed by calling thread, because
+		 *		they keep order of children
 		 */
-		int get_forward_id();
+		Edge_store(const Tree &tree, string map_file = "", Thread_pool *pool = NULL);
 
 		/**
-		 * Method returns id of reverse edge
-		 * @return id of edge in reverse direction
+		 * Method sends store from main process to every other process,
+		 * targets and euler successors are sent, or with mapped file
+		 * only its shape is sent and other processes map same file
+		 * @param rank rank of calling process
+		 * @param map_file path of file written by main process (empty
+		 *		for store in memory)
 		 */
-		int get_reverse_id();
+		void broadcast(int rank, string map_file = "");
 
 		/**
-		 * Getter of the saved name of node
-		 * @return name of node from which forward node is going
+		 * Getter of number of edges
+		 * @return number of edges (ids are 1..edge count)
 		 */
-		char get_node_id();
+		index_t get_edge_count() const;
 
 		/**
-		 * Getter of inserted_as_forward flag
-		 * @return value of flag inserted_as_forward
+		 * Getter of first edge of euler tour (first edge in list of root)
+		 * @return id of head of euler tour
 		 */
-		bool is_forward_elem();
-};
+		index_t get_head() const;
 
-class Nodes {
-	private:
-		int preorder_position;
-		char node_name;
-	public:
-		int get_preorder_position();
-		char get_node_name();
-		Nodes(int preorder_position, char name);
-};
+		/**
+		 * Getter of last edge going to root (aka ending edge of euler tour)
+		 * @return id of ending edge
+		 */
+		index_t get_ending_edge() const;
+
+		/**
+		 * Getter of start node of edge
+		 * @param edge_id id of edge
+		 * @return id of node from which edge is starting
+		 */
+		index_t get_source(index_t edge_id) const;
+
+		/**
+		 * Getter of end node of edge
+		 * @param edge_id id of edge
+		 * @return id of node in which edge is ending
+		 */
+		index_t get_target(index_t edge_id) const;
 
-/// type of adj list (lists implemented using vectors)
-typedef vector<vector<Adj_elem>> adj_t;
+		/**
+		 * Method returns id of reverse edge
+		 * @param edge_id id of edge
+		 * @return id of edge in opposite direction
+		 */
+		index_t get_reverse_id(index_t edge_id) const;
 
-/// type of list of edges (list implemented as vector)
-typedef vector<Edge> edge_list_t;
+		/**
+		 * Method returns successor of edge in euler tour
+		 * @param edge_id id of edge
+		 * @return id of next edge in euler tour (edge itself for ending edge)
+		 */
+		index_t get_euler_next(index_t edge_id) const;
 
-typedef vector<Nodes> node_list_t;
+		/**
+		 * Method checks, if edge is forward (aka goes from parent to child)
+		 * @param edge_id id of edge
+		 * @return true, if edge is forward
+		 */
+		bool is_forward(index_t edge_id) const;
+};
 
 class utility {
 	public:
@@ -148,147 +387,360 @@ class utility {
 		 * Class method checks, wheter edge (specified by id) is 
 		 * forward edge, or reverse edge
 		 * @param edge_id id of edge
-		 * @param adj adj list, where edge is stored
+		 * @param edges store of edges
 		 * @return true, if edge specified by id is forward, else return false
 		 */
-		static bool is_forward(int edge_id, adj_t adj) {
-			for (int i = 0; i < adj.size(); i++) {
-				for (int j = 0; j < adj[i].size(); j++) {
-					if (!adj[i][j].is_forward_elem()) {
-						continue;
-					}
-					if (adj[i][j].get_forward_id() == edge_id) {
-						return true;
-					}
-					if (adj[i][j].get_reverse_id() == edge_id) {
-						return false;
-					}
-				}
-			}
-			throw "Unknown edge id";
+		static bool is_forward(index_t edge_id, const Edge_store &edges) {
+			return edges.is_forward(edge_id);
 		}
 
 		/**
 		 * Method counts value of euler tour elem for one edge
 		 * 
-		 * 1.  Find the edge in adj by edge id
-		 * 2.  take id of reverse edge of searched edge
-		 * 3.  find the reverse edge as forward edge in adj
-		 * 3a. if there is any element in list after edge found in (3),
-		 *			then result is id of next forward edge
-		 * 3b. if there is no element in list after edge found in (3),
-		 *			then result is id of forward edge in first element of list
+		 * next edge in euler tour is edge following reverse edge of
+		 * given edge in adj list (first edge of list follows last one)
 		 *
 		 * @param edge_id id of edge
-		 * @param adj adj list, where edge is stored
-		 * @return id of edge, which is next in euler tour, in adj
-		 */
-		static int euler_tour(int edge_id, adj_t adj) {
-			// find reverse edge id for given forward edge id
-			int reverse_id = -1;
-			for (int i = 0; i < adj.size(); i++) {
-				for (int j = 0; j < adj[i].size(); j++) {
-					if (adj[i][j].get_forward_id() == edge_id) {
-						reverse_id = adj[i][j].get_reverse_id();
-					}
-				}
-			}
-			if (reverse_id == -1) {
-				throw "Edge id not found in adj";
-			}
+		 * @param edges store of edges
+		 * @return id of edge, which is next in euler tour (edge itself
+		 * for last edge going to root)
+		 */
+		static index_t euler_tour(index_t edge_id, const Edge_store &edges) {
+			return edges.get_euler_next(edge_id);
+		}
 
-			// find id of reverse edge as forward edge
-			for (int i = 0; i < adj.size(); i++) {
-				for (int j = 0; j < adj[i].size(); j++) {
-					if (adj[i][j].get_forward_id() == reverse_id) {
-						if (j == adj[i].size() - 1) {
-							// if element is at last index, return
-							// id of first forward edge in given list
-							return adj[i][0].get_forward_id();
-
-						} else {
-							// if element is not at last index, return
-							// id of first forward edge in given list
-							return adj[i][j + 1].get_forward_id();
-						}
-					}
-				}
+		/**
+		 * Method prints store of edges in readable format
+		 * @param edges store of edges
+		 */
+		static void print_edge_store(const Edge_store &edges) {
+			for (index_t i = 1; i <= edges.get_edge_count(); i++) {
+				cout << i << ":" << edges.get_source(i) << "->" << edges.get_target(i) << " next " << edges.get_euler_next(i) << endl;
 			}
-			throw "Id of reverse edge not found in adj";
 		}
 
 		/**
-		 * Method adds vector of adj elements into adj
-		 * @param edge_vector vector containing adj elements
-		 * @param adj adjacency list representing graph (aka tree with reverse edges)
-		 * @return adjacency list containing given edge vector and previously added vectors
+		 * Method returns index of child node of edge in implicit heap
+		 *
+		 * in heap, edges going to/from node with index c are created
+		 * in pairs: forward edge has id 2c - 1, reverse edge has id 2c
+		 *
+		 * @param edge_id id of edge
+		 * @return index of node, which is child in given edge
 		 */
-		static adj_t push_edge_vector(vector<Adj_elem> edge_vector, adj_t adj) {
-			for (int i = 0; i < adj.size(); i++) {
-				// if there is list for given node, then append it
-				if (adj[i][0].get_node_id() == edge_vector[0].get_node_id()) {
-					adj[i].insert(adj[i].end(), edge_vector.begin(), edge_vector.end());
-					return adj;
-				}
-			}
-			// if no list found for given node, then create new list
-			adj.push_back(edge_vector);
-			return adj;
+		static index_t heap_edge_child(index_t edge_id) {
+			return (edge_id + 1) / 2;
 		}
 
 		/**
-		 * Method prints adjacency list in readable format
-		 * @param adj adjacency list to be printed
+		 * Method checks, if edge in implicit heap is forward edge
+		 * @param edge_id id of edge
+		 * @return true, if edge goes from parent to child
 		 */
-		static void print_adj(adj_t adj) {
-			for (int i = 0; i < adj.size(); i++) {
-				cout << adj[i][0].get_node_id() << ": ";
-				for (int j = 0; j < adj[i].size(); j++) {
-					cout << "(" << adj[i][j].get_forward_id() << ";" << adj[i][j].get_reverse_id() << ") ";
-				}
-				cout << endl;
-			}
+		static bool heap_is_forward(index_t edge_id) {
+			return edge_id % 2 == 1;
 		}
 
 		/**
-		 * Method for printing edge list
-		 * @param edge_list list of edges
+		 * Method returns id of reverse edge in implicit heap
+		 * @param edge_id id of edge
+		 * @return id of edge in opposite direction
 		 */
-		static void print_edge_list(edge_list_t edge_list) {
-			for (int i = 0; i < edge_list.size(); i++) {
-				cout << edge_list[i].get_id() << ":" << edge_list[i].get_start_node() << "->" << edge_list[i].get_end_node() << endl;
-			}
+		static index_t heap_reverse(index_t edge_id) {
+			return utility::heap_is_forward(edge_id) ? edge_id + 1 : edge_id - 1;
 		}
 
 		/**
-		 * Method finds last edge going to root and set its euler next edge to itself
-		 * 
-		 * @param euler_tour vector containing on index i+1 (aka id of edge) next edge in euler tour (as id of that edge)
-		 * @param edge_list list of edges in which search can be done
-		 * @param root_name name (aka id) of root of tree
-		 * @return fixed euler tour (last edge going to root pointing to itself)
-		 */
-		static vector<int> fix_euler_tour(vector<int> euler_tour, vector<Edge> edge_list, char root_name) {
-			// find last edge ending in root node
-			int edge_id;
-			for (int i = 0; i < edge_list.size(); i++) {
-				if (edge_list[i].get_end_node() == root_name) {
-					edge_id = edge_list[i].get_id();
-				}
-			}
+		 * Method returns index of node, in which edge in implicit heap starts
+		 * @param edge_id id of edge
+		 * @return index of start node
+		 */
+		static index_t heap_edge_start(index_t edge_id) {
+			index_t child = utility::heap_edge_child(edge_id);
+			return utility::heap_is_forward(edge_id) ? (child - 1) / 2 : child;
+		}
+
+		/**
+		 * Method returns index of node, in which edge in implicit heap ends
+		 * @param edge_id id of edge
+		 * @return index of end node
+		 */
+		static index_t heap_edge_end(index_t edge_id) {
+			index_t child = utility::heap_edge_child(edge_id);
+			return utility::heap_is_forward(edge_id) ? child : (child - 1) / 2;
+		}
 
-			// for searched edge, replace id of euler tour by self id
-			euler_tour[edge_id - 1] = edge_id;
-			return euler_tour;
+		/**
+		 * Method returns id of ending edge of euler tour in implicit heap
+		 * @param node_count number of nodes in tree (at least 2)
+		 * @return id of reverse edge from last child of root
+		 */
+		static index_t heap_ending_edge(index_t node_count) {
+			return node_count > 2 ? 4 : 2;
 		}
 
-		static int update_ending_edge_noticing_sum(int current_value, int size) {
-			return min(size - 1, ((current_value * 2) - 1));
+		/**
+		 * Method counts value of euler tour elem for one edge in implicit heap
+		 *
+		 * adj list of node c would be (c -> parent, c -> left, c -> right),
+		 * so next edge is derived directly from indexes of nodes:
+		 * 1.  forward edge p -> c continues to left child of c,
+		 *			if c is leaf, then it returns by c -> p
+		 * 2.  reverse edge c -> p continues to right sibling of c,
+		 *			if there is no sibling, then it continues to parent of p
+		 * 3.  reverse edge of last child of root is ending edge (points to itself)
+		 *
+		 * @param edge_id id of edge
+		 * @param node_count number of nodes in tree
+		 * @return id of edge, which is next in (fixed) euler tour
+		 */
+		static index_t heap_euler_tour(index_t edge_id, index_t node_count) {
+			index_t child = utility::heap_edge_child(edge_id);
+			if (utility::heap_is_forward(edge_id)) {
+				index_t left = 2 * child + 1;
+				return left < node_count ? 2 * left - 1 : edge_id + 1;
+			}
+			index_t parent = (child - 1) / 2;
+			if (child % 2 == 1 && child + 1 < node_count) {
+				return 2 * (child + 1) - 1;
+			}
+			return parent != 0 ? 2 * parent : edge_id;
 		}
 
-		static int preorder(int weight, int size) {
+		static index_t preorder(index_t weight, index_t size) {
 			return size - weight;
 		}
+
+		/**
+		 * Method counts number of pointer jumping rounds needed to
+		 * reach end of list of given length
+		 * @param length number of elements in list
+		 * @return number of rounds (ceil of binary log of length)
+		 */
+		static int pointer_jumping_rounds(index_t length) {
+			int rounds = 0;
+			while (((index_t) 1 << rounds) < length) {
+				rounds++;
+			}
+			return rounds;
+		}
+
+		/**
+		 * Method decides, if edge is splitter of list ranking
+		 *
+		 * decision depends only on id of edge (hashed, so splitters are
+		 * spread over euler tour), so every process can evaluate it also
+		 * for edges owned by another process
+		 *
+		 * @param edge_id id of edge
+		 * @param head id of first edge in euler tour (always splitter)
+		 * @param stride on average every stride-th edge is splitter
+		 * @return true, if edge starts new sublist
+		 */
+		static bool is_splitter(index_t edge_id, index_t head, int stride) {
+			unsigned long long hash = ((unsigned long long) edge_id * 11400714819323198485ull) >> 32;
+			return edge_id == head || hash % stride == 0;
+		}
 };
 
+/**
+ * Function counts suffix sum of list distributed in blocks using
+ * pointer jumping, processes exchange only values of successors,
+ * which are stored in block of another process
+ *
+ * runs of edges linked inside block are ranked locally first (see
+ * local_list_rank), so only first edges of runs take part in exchange
+ * and number of rounds depends on number of runs, not edges
+ * (rounds stop, when every edge reaches end of list)
+ * @param weight weights of edges in block, replaced by suffix sums
+ * @param euler_next successors of edges in block (ending edge points to itself)
+ * @param block distribution of edges to processes
+ * @param rank rank of calling process
+ */
+void block_suffix_sum(vector<index_t> &weight, vector<index_t> &euler_next, Edge_block block, int rank);
+
+/**
+ * Function counts suffix sum of list distributed in blocks using
+ * pointer jumping, weights and successors are exposed in MPI window,
+ * so each process reads values of remote successors by MPI_Get and
+ * rounds are separated only by fences (and reduction of flag, which
+ * stops rounds, when every edge reaches end of list)
+ * @param weight weights of edges in block, replaced by suffix sums
+ * @param euler_next successors of edges in block (ending edge points to itself)
+ * @param block distribution of edges to processes
+ * @param rank rank of calling process
+ */
+void rma_suffix_sum(vector<index_t> &weight, vector<index_t> &euler_next, Edge_block block, int rank);
+
+/**
+ * Function counts suffix sum of list distributed in blocks by ruling set
+ * list ranking (Helman and JaJa), which does O(n) work in total
+ *
+ * 1. some edges are chosen as splitters, each splitter starts sublist
+ *		ending before next splitter
+ * 2. sublists are walked, walk continues locally while successor is in
+ *		same block, else walker is sent to owner of successor
+ * 3. reduced list of splitters (weighted by sums of sublists) is ranked
+ *		by main process and suffix sums of splitters are broadcast back
+ *		(O(n/log n) splitters are held by every process)
+ * 4. suffix sum of edge is counted from suffix sum of its splitter
+ *
+ * @param weight weights of edges in block, replaced by suffix sums
+ * @param euler_next successors of edges in block (ending edge points to itself)
+ * @param block distribution of edges to processes
+ * @param rank rank of calling process
+ * @param head id of first edge in euler tour
+ */
+void ruling_set_suffix_sum(vector<index_t> &weight, vector<index_t> &euler_next, Edge_block block, int rank, index_t head);
+
+/**
+ * Function counts suffix sum with one edge per process by pointer jumping
+ * over nonblocking messages (no coordinator, called by processes with edge)
+ *
+ * every edge keeps its predecessor, so in each round edge sends packed
+ * pair (weight, next) to predecessor and its predecessor to next edge,
+ * both receives are posted ahead and round ends by MPI_Waitall, ending
+ * edge is left out of list, so edges pointing to it have no successor
+ * and edge without successor and predecessor stops (ids are int, tree
+ * has fewer edges than processes)
+ * @param weight weight of edge, replaced by suffix sum
+ * @param euler_next successor of edge (replaced by ending edge)
+ * @param edge_id id of edge (aka rank of process)
+ * @param head first edge of euler tour
+ * @param ending_edge last edge of euler tour (pointing to itself)
+ */
+void nonblocking_suffix_sum(int &weight, int &euler_next, int edge_id, int head, int ending_edge);
+
+/**
+ * Function checks, if every node of tree with distributed parent array
+ * reaches root (collective, every process throws same error)
+ *
+ * every node jumps to ancestor of its ancestor, so after ceil(log2 n)
+ * rounds node of tree knows root, node left with other ancestor is
+ * on cycle or below it (only nodes not knowing root take part in round)
+ * @param tree input tree with distributed parent array
+ * @param rank rank of calling process
+ * @param size total number of processes
+ */
+void distributed_check_tree(const Tree &tree, int rank, int size);
+
+/**
+ * Function creates euler tour of edges in block of calling process for
+ * tree with distributed parent array (see Tree::read_parallel)
+ *
+ * 1. pairs (parent, child) are sent to owner of parent, which sorts them
+ *    and finds first child of parent and next sibling of every child
+ * 2. next siblings are sent back to owners of children
+ * 3. owner of node counts successors of both edges of node and sends
+ *    them to owners of edges (mostly itself, only edges on boundaries
+ *    of blocks are sent to neighbours)
+ * @param tree input tree with distributed parent array
+ * @param block distribution of edges to processes (placed, if -g is given)
+ * @param rank rank of calling process
+ * @param size total number of processes
+ * @param euler_next successors of edges in block (ending edge points to itself)
+ * @param forward flags of edges in block, true for forward edges
+ * @return id of first edge in euler tour
+ */
+index_t distributed_euler_tour(const Tree &tree, Edge_block block, int rank, int size,
+		vector<index_t> &euler_next, vector<bool> &forward);
+
+/**
+ * Function creates euler tour of edges in block of calling process
+ * (store of edges is created and broadcast only if tree is not implicit heap)
+ * @param options settings given on command line
+ * @param tree input tree
+ * @param block distribution of edges to processes (placed, if -g is given)
+ * @param rank rank of calling process
+ * @param size total number of processes
+ * @param euler_next successors of edges in block (ending edge points to itself)
+ * @param forward flags of edges in block, true for forward edges
+ * @return id of first edge in euler tour
+ */
+index_t block_euler_tour(Options options, const Tree &tree, Edge_block &block, int rank, int size,
+		vector<index_t> &euler_next, vector<bool> &forward);
+
+/**
+ * Function derives successors of edges in block from edge ids
+ * @param options settings given on command line
+ * @param edges store of edges (empty for implicit heap)
+ * @param node_count number of nodes of tree
+ * @param first id of first edge in block
+ * @param count number of edges in block
+ * @param euler_next successors of edges in block (ending edge points to itself)
+ * @param forward flags of edges in block, true for forward edges
+ */
+void local_euler_tour(Options options, const Edge_store &edges, index_t node_count, index_t first, index_t count,
+		vector<index_t> &euler_next, vector<bool> &forward);
+
+/**
+ * Function places blocks to processes by topology of machine (collective),
+ * blocks are vertices of distributed graph weighted by number of tour
+ * links between them and MPI reorders ranks of graph communicator
+ * @param block distribution of edges to processes (placement is set)
+ * @param euler_next successors of edges in block of calling process
+ * @param rank rank of calling process
+ * @param size total number of processes
+ */
+void place_blocks(Edge_block &block, const vector<index_t> &euler_next, int rank, int size);
+
+/**
+ * Function computes tree numbers given by -c flag with edges distributed
+ * in blocks and prints them for every node
+ * @param options settings given on command line
+ * @param tree input tree
+ * @param rank rank of calling process
+ * @param size total number of processes
+ */
+void block_tree_numbers(Options options, const Tree &tree, int rank, int size);
+
+/**
+ * Function computes preorder with edges distributed in blocks, with
+ * -x preorder is written to scratch file and printed from its mapping
+ * (see write_preorder), else it is gathered to main process
+ * @param options settings given on command line
+ * @param tree input tree (only number of nodes and root on non-main
+ *		processes, if tree is not implicit heap)
+ * @param rank rank of calling process
+ * @param size total number of processes
+ */
+void block_preorder(Options options, const Tree &tree, int rank, int size);
+
+/**
+ * Function writes preorder to binary file by all processes (collective),
+ * every process writes only nodes placed by its forward edges (and main
+ * process writes root), so result is not gathered, nodes are written
+ * in pieces of at most MESSAGE_MAX_BYTES bytes
+ * @param file_name path of output file
+ * @param tree input tree
+ * @param positions pairs (forward edge id, preorder position) of block
+ * @param rank rank of calling process
+ */
+void write_preorder(string file_name, const Tree &tree, const vector<index_t> &positions, int rank);
+
+/**
+ * Function prints preorder of every tree of forest (called by main process)
+ * @param tree input forest
+ * @param positions pairs (forward edge id, suffix sum inside its tree)
+ */
+void forest_print(const Tree &tree, const vector<index_t> &positions);
+
+/**
+ * Function runs backend, which does not need MPI (sequential DFS,
+ * incremental preorder or threads), and prints result
+ * @param options settings given on command line
+ * @return exit code of program
+ */
+int local_preorder(Options options);
+
+/**
+ * Function reads tree and runs all phases of chosen MPI backend
+ * (collective, every process must call it with same options)
+ * @param options settings given on command line
+ * @param rank rank of calling process
+ * @param size total number of processes
+ * @return exit code of program (same on every process)
+ */
+int mpi_preorder(Options options, int rank, int size);
+
 #endif
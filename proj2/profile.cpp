@@ -0,0 +1,364 @@
+/**
+ * @file profile.cpp
+ * @author Jiri Kristof, <xkrist22@stud.fit.vutbr.cz>
+ * @brief implementation of instrumentation of project "preorder tree"
+ */
+
+#include <string.h>
+#include <algorithm>
+#include "profile.h"
+
+bool Profile::enabled = false;
+string Profile::output;
+vector<phase_stats_t> Profile::phases;
+int Profile::current = -1;
+double Profile::phase_start = 0;
+
+void Profile::enable(string output) {
+	Profile::output = output;
+	Profile::enabled = true;
+	Profile::phase(PHASE_STARTUP);
+}
+
+bool Profile::is_enabled() {
+	return Profile::enabled;
+}
+
+void Profile::stop() {
+	if (Profile::current >= 0) {
+		Profile::phases[Profile::current].time += MPI_Wtime() - Profile::phase_start;
+	}
+}
+
+void Profile::phase(string name) {
+	if (!Profile::enabled) {
+		return;
+	}
+	Profile::stop();
+	Profile::current = -1;
+	for (int i = 0; i < Profile::phases.size(); i++) {
+		if (name == Profile::phases[i].name) {
+			Profile::current = i;
+		}
+	}
+	if (Profile::current < 0) {
+		phase_stats_t stats;
+		memset(&stats, 0, sizeof(stats));
+		strncpy(stats.name, name.c_str(), PHASE_NAME_LEN - 1);
+		Profile::phases.push_back(stats);
+		Profile::current = Profile::phases.size() - 1;
+	}
+	Profile::phase_start = MPI_Wtime();
+}
+
+void Profile::round() {
+	if (Profile::enabled) {
+		Profile::phases[Profile::current].rounds++;
+	}
+}
+
+void Profile::sent(long long messages, long long bytes) {
+	if (Profile::enabled) {
+		Profile::phases[Profile::current].sent_messages += messages;
+		Profile::phases[Profile::current].sent_bytes += bytes;
+	}
+}
+
+void Profile::recieved(long long messages, long long bytes) {
+	if (Profile::enabled) {
+		Profile::phases[Profile::current].recv_messages += messages;
+		Profile::phases[Profile::current].recv_bytes += bytes;
+	}
+}
+
+void Profile::report() {
+	if (!Profile::enabled) {
+		return;
+	}
+	Profile::stop();
+	// communication of report is not counted
+	Profile::enabled = false;
+
+	int rank, size;
+	PMPI_Comm_rank(MPI_COMM_WORLD, &rank);
+	PMPI_Comm_size(MPI_COMM_WORLD, &size);
+
+	// statistics are sent as bytes, every process can have other phases
+	int bytes = Profile::phases.size() * sizeof(phase_stats_t);
+	vector<int> recv_counts(size), recv_displs(size);
+	PMPI_Gather(&bytes,1,MPI_INT,recv_counts.data(),1,MPI_INT,0,MPI_COMM_WORLD);
+	int recv_total = 0;
+	for (int i = 0; i < size; i++) {
+		recv_displs[i] = recv_total;
+		recv_total += recv_counts[i];
+	}
+	vector<phase_stats_t> all_phases(rank == 0 ? recv_total / sizeof(phase_stats_t) : 0);
+	PMPI_Gatherv(Profile::phases.data(),bytes,MPI_BYTE,all_phases.data(),
+		recv_counts.data(),recv_displs.data(),MPI_BYTE,0,MPI_COMM_WORLD);
+
+	if (rank == 0) {
+		vector<vector<phase_stats_t>> stats(size);
+		for (int i = 0; i < size; i++) {
+			int first = recv_displs[i] / sizeof(phase_stats_t);
+			int count = recv_counts[i] / sizeof(phase_stats_t);
+			stats[i].assign(all_phases.begin() + first, all_phases.begin() + first + count);
+		}
+		Profile::write(stats, size);
+	}
+}
+
+void Profile::write(const vector<vector<phase_stats_t>> &stats, int size) {
+	FILE *file = Profile::output == PROFILE_STDOUT ? stdout : fopen(Profile::output.c_str(), "w");
+	if (file == NULL) {
+		fprintf(stderr, "cannot open profile output file\n");
+		return;
+	}
+
+	// phases are ordered by their first occurrence
+	vector<string> names;
+	for (int i = 0; i < size; i++) {
+		for (int j = 0; j < stats[i].size(); j++) {
+			if (find(names.begin(), names.end(), string(stats[i][j].name)) == names.end()) {
+				names.push_back(stats[i][j].name);
+			}
+		}
+	}
+
+	fprintf(file, "{\n\t\"processes\": %d,\n\t\"phases\": [", size);
+	for (int p = 0; p < names.size(); p++) {
+		// totals of phase, time of phase is time of slowest process
+		phase_stats_t total;
+		memset(&total, 0, sizeof(total));
+		string ranks;
+		for (int i = 0; i < size; i++) {
+			for (int j = 0; j < stats[i].size(); j++) {
+				const phase_stats_t &s = stats[i][j];
+				if (names[p] != s.name) {
+					continue;
+				}
+				total.time = max(total.time, s.time);
+				total.sent_messages += s.sent_messages;
+				total.recv_messages += s.recv_messages;
+				total.sent_bytes += s.sent_bytes;
+				total.recv_bytes += s.recv_bytes;
+				total.rounds = max(total.rounds, s.rounds);
+				char line[256];
+				snprintf(line, sizeof(line), "%s\n\t\t\t\t{\"rank\": %d, \"time\": %.9f, \"sent_messages\": %lld, \"recv_messages\": %lld, "
+					"\"sent_bytes\": %lld, \"recv_bytes\": %lld, \"rounds\": %lld}",
+					ranks.empty() ? "" : ",", i, s.time, s.sent_messages, s.recv_messages, s.sent_bytes, s.recv_bytes, s.rounds);
+				ranks += line;
+			}
+		}
+		fprintf(file, "%s\n\t\t{\n\t\t\t\"name\": \"%s\",\n", p == 0 ? "" : ",", names[p].c_str());
+		fprintf(file, "\t\t\t\"time\": %.9f,\n\t\t\t\"sent_messages\": %lld,\n\t\t\t\"recv_messages\": %lld,\n", total.time, total.sent_messages, total.recv_messages);
+		fprintf(file, "\t\t\t\"sent_bytes\": %lld,\n\t\t\t\"recv_bytes\": %lld,\n\t\t\t\"rounds\": %lld,\n", total.sent_bytes, total.recv_bytes, total.rounds);
+		fprintf(file, "\t\t\t\"ranks\": [%s\n\t\t\t]\n\t\t}", ranks.c_str());
+	}
+	fprintf(file, "\n\t]\n}\n");
+	if (file == stdout) {
+		fflush(file);
+	} else {
+		fclose(file);
+	}
+}
+
+/**** MPI WRAPPERS ****/
+
+/**
+ * Function returns size of values in bytes
+ * @param count number of values
+ * @param type type of values
+ * @return size of values
+ */
+static long long type_bytes(long long count, MPI_Datatype type) {
+	int type_size;
+	PMPI_Type_size(type, &type_size);
+	return count * type_size;
+}
+
+/**
+ * Function returns rank of calling process in communicator
+ * @param comm communicator
+ * @return rank of calling process
+ */
+static int comm_rank(MPI_Comm comm) {
+	int rank;
+	PMPI_Comm_rank(comm, &rank);
+	return rank;
+}
+
+/**
+ * Function returns size of communicator
+ * @param comm communicator
+ * @return number of processes
+ */
+static int comm_size(MPI_Comm comm) {
+	int size;
+	PMPI_Comm_size(comm, &size);
+	return size;
+}
+
+int MPI_Send(const void *buf, int count, MPI_Datatype datatype, int dest, int tag, MPI_Comm comm) {
+	Profile::sent(1, type_bytes(count, datatype));
+	return PMPI_Send(buf, count, datatype, dest, tag, comm);
+}
+
+int MPI_Recv(void *buf, int count, MPI_Datatype datatype, int source, int tag, MPI_Comm comm, MPI_Status *status) {
+	MPI_Status local_status;
+	if (status == MPI_STATUS_IGNORE) {
+		status = &local_status;
+	}
+	int result = PMPI_Recv(buf, count, datatype, source, tag, comm, status);
+	int recieved;
+	PMPI_Get_count(status, datatype, &recieved);
+	Profile::recieved(1, type_bytes(recieved, datatype));
+	return result;
+}
+
+int MPI_Isend(const void *buf, int count, MPI_Datatype datatype, int dest, int tag, MPI_Comm comm, MPI_Request *request) {
+	Profile::sent(1, type_bytes(count, datatype));
+	return PMPI_Isend(buf, count, datatype, dest, tag, comm, request);
+}
+
+int MPI_Irecv(void *buf, int count, MPI_Datatype datatype, int source, int tag, MPI_Comm comm, MPI_Request *request) {
+	// size of message is not known before completion, so size of buffer is counted
+	Profile::recieved(1, type_bytes(count, datatype));
+	return PMPI_Irecv(buf, count, datatype, source, tag, comm, request);
+}
+
+int MPI_Bcast(void *buffer, int count, MPI_Datatype datatype, int root, MPI_Comm comm) {
+	int size = comm_size(comm);
+	if (size > 1) {
+		// counted as if root sent message to every other process
+		if (comm_rank(comm) == root) {
+			Profile::sent(size - 1, (size - 1) * type_bytes(count, datatype));
+		} else {
+			Profile::recieved(1, type_bytes(count, datatype));
+		}
+	}
+	return PMPI_Bcast(buffer, count, datatype, root, comm);
+}
+
+int MPI_Ibcast(void *buffer, int count, MPI_Datatype datatype, int root, MPI_Comm comm, MPI_Request *request) {
+	int size = comm_size(comm);
+	if (size > 1) {
+		if (comm_rank(comm) == root) {
+			Profile::sent(size - 1, (size - 1) * type_bytes(count, datatype));
+		} else {
+			Profile::recieved(1, type_bytes(count, datatype));
+		}
+	}
+	return PMPI_Ibcast(buffer, count, datatype, root, comm, request);
+}
+
+int MPI_Alltoall(const void *sendbuf, int sendcount, MPI_Datatype sendtype,
+		void *recvbuf, int recvcount, MPI_Datatype recvtype, MPI_Comm comm) {
+	int size = comm_size(comm);
+	Profile::sent(size - 1, (size - 1) * type_bytes(sendcount, sendtype));
+	Profile::recieved(size - 1, (size - 1) * type_bytes(recvcount, recvtype));
+	return PMPI_Alltoall(sendbuf, sendcount, sendtype, recvbuf, recvcount, recvtype, comm);
+}
+
+int MPI_Alltoallv(const void *sendbuf, const int sendcounts[], const int sdispls[], MPI_Datatype sendtype,
+		void *recvbuf, const int recvcounts[], const int rdispls[], MPI_Datatype recvtype, MPI_Comm comm) {
+	// only nonempty messages to other processes are counted
+	int rank = comm_rank(comm);
+	int size = comm_size(comm);
+	for (int i = 0; i < size; i++) {
+		if (i != rank && sendcounts[i] > 0) {
+			Profile::sent(1, type_bytes(sendcounts[i], sendtype));
+		}
+		if (i != rank && recvcounts[i] > 0) {
+			Profile::recieved(1, type_bytes(recvcounts[i], recvtype));
+		}
+	}
+	return PMPI_Alltoallv(sendbuf, sendcounts, sdispls, sendtype, recvbuf, recvcounts, rdispls, recvtype, comm);
+}
+
+int MPI_Gather(const void *sendbuf, int sendcount, MPI_Datatype sendtype,
+		void *recvbuf, int recvcount, MPI_Datatype recvtype, int root, MPI_Comm comm) {
+	int size = comm_size(comm);
+	if (comm_rank(comm) == root) {
+		Profile::recieved(size - 1, (size - 1) * type_bytes(recvcount, recvtype));
+	} else {
+		Profile::sent(1, type_bytes(sendcount, sendtype));
+	}
+	return PMPI_Gather(sendbuf, sendcount, sendtype, recvbuf, recvcount, recvtype, root, comm);
+}
+
+int MPI_Gatherv(const void *sendbuf, int sendcount, MPI_Datatype sendtype,
+		void *recvbuf, const int recvcounts[], const int displs[], MPI_Datatype recvtype, int root, MPI_Comm comm) {
+	int rank = comm_rank(comm);
+	if (rank == root) {
+		int size = comm_size(comm);
+		for (int i = 0; i < size; i++) {
+			if (i != root) {
+				Profile::recieved(1, type_bytes(recvcounts[i], recvtype));
+			}
+		}
+	} else {
+		Profile::sent(1, type_bytes(sendcount, sendtype));
+	}
+	return PMPI_Gatherv(sendbuf, sendcount, sendtype, recvbuf, recvcounts, displs, recvtype, root, comm);
+}
+
+int MPI_Scatter(const void *sendbuf, int sendcount, MPI_Datatype sendtype,
+		void *recvbuf, int recvcount, MPI_Datatype recvtype, int root, MPI_Comm comm) {
+	int size = comm_size(comm);
+	if (comm_rank(comm) == root) {
+		Profile::sent(size - 1, (size - 1) * type_bytes(sendcount, sendtype));
+	} else {
+		Profile::recieved(1, type_bytes(recvcount, recvtype));
+	}
+	return PMPI_Scatter(sendbuf, sendcount, sendtype, recvbuf, recvcount, recvtype, root, comm);
+}
+
+int MPI_Allreduce(const void *sendbuf, void *recvbuf, int count, MPI_Datatype datatype, MPI_Op op, MPI_Comm comm) {
+	// counted as one contribution and one result per process
+	if (comm_size(comm) > 1) {
+		Profile::sent(1, type_bytes(count, datatype));
+		Profile::recieved(1, type_bytes(count, datatype));
+	}
+	return PMPI_Allreduce(sendbuf, recvbuf, count, datatype, op, comm);
+}
+
+int MPI_Allgather(const void *sendbuf, int sendcount, MPI_Datatype sendtype,
+		void *recvbuf, int recvcount, MPI_Datatype recvtype, MPI_Comm comm) {
+	int size = comm_size(comm);
+	Profile::sent(size - 1, (size - 1) * type_bytes(sendcount, sendtype));
+	Profile::recieved(size - 1, (size - 1) * type_bytes(recvcount, recvtype));
+	return PMPI_Allgather(sendbuf, sendcount, sendtype, recvbuf, recvcount, recvtype, comm);
+}
+
+int MPI_Barrier(MPI_Comm comm) {
+	// counted as one empty contribution and one release per process
+	if (comm_size(comm) > 1) {
+		Profile::sent(1, 0);
+		Profile::recieved(1, 0);
+	}
+	return PMPI_Barrier(comm);
+}
+
+int MPI_File_read_at_all(MPI_File fh, MPI_Offset offset, void *buf, int count,
+		MPI_Datatype datatype, MPI_Status *status) {
+	// file access is counted as message from (or to) file system
+	Profile::recieved(1, type_bytes(count, datatype));
+	return PMPI_File_read_at_all(fh, offset, buf, count, datatype, status);
+}
+
+int MPI_File_write_at_all(MPI_File fh, MPI_Offset offset, const void *buf, int count,
+		MPI_Datatype datatype, MPI_Status *status) {
+	Profile::sent(1, type_bytes(count, datatype));
+	return PMPI_File_write_at_all(fh, offset, buf, count, datatype, status);
+}
+
+int MPI_Get(void *origin_addr, int origin_count, MPI_Datatype origin_datatype, int target_rank,
+		MPI_Aint target_disp, int target_count, MPI_Datatype target_datatype, MPI_Win win) {
+	Profile::recieved(1, type_bytes(origin_count, origin_datatype));
+	return PMPI_Get(origin_addr, origin_count, origin_datatype, target_rank, target_disp, target_count, target_datatype, win);
+}
+
+int MPI_Finalize() {
+	Profile::report();
+	return PMPI_Finalize();
+}
@@ -0,0 +1,113 @@
+/**
+ * @file profile.h
+ * @author Jiri Kristof, <xkrist22@stud.fit.vutbr.cz>
+ * @brief header file of instrumentation of project "preorder tree"
+ *
+ * communication is counted by wrappers of MPI functions (profiling
+ * interface, wrappers call PMPI functions), phases are marked by
+ * program in places of phase banners, statistics of all processes
+ * are reduced to main process and written as JSON in MPI_Finalize
+ */
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdio.h>
+#include <mpi.h>
+#include <string>
+#include <vector>
+
+// name of output file meaning standard output
+#define PROFILE_STDOUT "-"
+
+// phase running from MPI_Init to first phase banner
+#define PHASE_STARTUP "STARTUP"
+
+// maximal length of phase name (including terminating zero)
+#define PHASE_NAME_LEN 48
+
+using namespace std;
+
+/**
+ * Structure of statistics of one phase on one process
+ */
+typedef struct {
+	char name[PHASE_NAME_LEN];
+	double time;
+	long long sent_messages;
+	long long recv_messages;
+	long long sent_bytes;
+	long long recv_bytes;
+	long long rounds;
+} phase_stats_t;
+
+/**
+ * Class collects statistics of phases of calling process
+ * (all methods are static, there is only one profile per process)
+ */
+class Profile {
+	private:
+		static bool enabled;
+		static string output;
+		static vector<phase_stats_t> phases;
+		static int current;
+		static double phase_start;
+
+		/**
+		 * Method adds time from start of current phase to its statistics
+		 */
+		static void stop();
+
+		/**
+		 * Method writes statistics of all processes as JSON
+		 * @param stats statistics of phases of every process
+		 * @param size total number of processes
+		 */
+		static void write(const vector<vector<phase_stats_t>> &stats, int size);
+	public:
+		/**
+		 * Method starts profiling, it is called after MPI_Init
+		 * @param output name of JSON file (PROFILE_STDOUT for standard output)
+		 */
+		static void enable(string output);
+
+		/**
+		 * Method checks, if profiling is running
+		 * @return true, if statistics are collected
+		 */
+		static bool is_enabled();
+
+		/**
+		 * Method ends current phase and starts given one (statistics
+		 * of phases with same name are summed)
+		 * @param name name of phase (as in banner in source code)
+		 */
+		static void phase(string name);
+
+		/**
+		 * Method counts one round of suffix sum
+		 */
+		static void round();
+
+		/**
+		 * Method counts sent messages
+		 * @param messages number of messages
+		 * @param bytes total size of messages
+		 */
+		static void sent(long long messages, long long bytes);
+
+		/**
+		 * Method counts received messages
+		 * @param messages number of messages
+		 * @param bytes total size of messages
+		 */
+		static void recieved(long long messages, long long bytes);
+
+		/**
+		 * Method reduces statistics to main process, which writes them
+		 * (collective, called from MPI_Finalize wrapper)
+		 */
+		static void report();
+};
+
+#endif
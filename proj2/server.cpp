@@ -0,0 +1,213 @@
+/**
+ * @file server.cpp
+ * @author Jiri Kristof <xkrist22@stud.fit.vutbr.cz>
+ * @brief File contains server mode of project "preorder tree"
+ */
+
+#include <ctype.h>
+#include <errno.h>
+#include <signal.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <sstream>
+#include "server.h"
+
+using namespace std;
+
+Options parse_query(string query) {
+	// arguments are separated by whitespaces, first one is name of program
+	vector<string> arguments(1, "pro");
+	istringstream stream(query);
+	string argument;
+	while (stream >> argument) {
+		arguments.push_back(argument);
+	}
+	vector<char *> argv;
+	for (int i = 0; i < arguments.size(); i++) {
+		argv.push_back((char *) arguments[i].c_str());
+	}
+	return Options(argv.size(), argv.data());
+}
+
+/**
+ * Function reads one line from connection
+ * @param connection descriptor of connected socket
+ * @return line without end of line
+ */
+static string read_query(int connection) {
+	// client, which does not send whole line, must not block server
+	struct timeval timeout;
+	timeout.tv_sec = SERVER_TIMEOUT;
+	timeout.tv_usec = 0;
+	setsockopt(connection, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+	string query;
+	char c;
+	while (true) {
+		ssize_t result = read(connection, &c, 1);
+		if (result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+			throw "Query is not ended in time";
+		}
+		if (result != 1 || c == '\n') {
+			break;
+		}
+		if (query.length() == SERVER_MAX_QUERY) {
+			throw "Query is too long";
+		}
+		query += c;
+	}
+	return query;
+}
+
+/**
+ * Function finds flag, which was not recognized by Options (flags
+ * without their value are taken as sequences)
+ * @param options settings of query
+ * @return unknown flag, empty if there is none
+ */
+static string unknown_flag(const Options &options) {
+	for (int i = 0; i < options.node_lists.size(); i++) {
+		const string &argument = options.node_lists[i];
+		if (argument.length() == 2 && argument[0] == '-' && isalpha(argument[1])) {
+			return argument;
+		}
+	}
+	return "";
+}
+
+/**
+ * Function waits for broadcast of main process, other processes sleep
+ * between checks, so idle server does not load cores
+ * @param buffer broadcast value
+ * @param count number of values
+ * @param type type of values
+ * @param rank rank of calling process
+ */
+static void idle_bcast(void *buffer, int count, MPI_Datatype type, int rank) {
+	MPI_Request request;
+	MPI_Ibcast(buffer,count,type,PROC_MAIN,MPI_COMM_WORLD,&request);
+	if (rank == PROC_MAIN) {
+		MPI_Wait(&request,MPI_STATUS_IGNORE);
+		return;
+	}
+	int done = 0;
+	while (true) {
+		MPI_Test(&request,&done,MPI_STATUS_IGNORE);
+		if (done) {
+			break;
+		}
+		usleep(SERVER_POLL_US);
+	}
+}
+
+int serve(Options options, int rank, int size) {
+	// socket is opened by main process, error is broadcast
+	int listener = -1;
+	int failed = 0;
+	if (rank == PROC_MAIN) {
+		struct sockaddr_un address;
+		memset(&address, 0, sizeof(address));
+		address.sun_family = AF_UNIX;
+		strncpy(address.sun_path, options.serve.c_str(), sizeof(address.sun_path) - 1);
+		unlink(address.sun_path);
+		listener = socket(AF_UNIX, SOCK_STREAM, 0);
+		if (listener < 0 || bind(listener, (struct sockaddr *) &address, sizeof(address)) < 0
+				|| listen(listener, SERVER_BACKLOG) < 0) {
+			fprintf(stderr, "Cannot open server socket\n");
+			failed = 1;
+		}
+		// client closing connection early must not stop server
+		signal(SIGPIPE, SIG_IGN);
+	}
+	MPI_Bcast(&failed,1,MPI_INT,PROC_MAIN,MPI_COMM_WORLD);
+	if (failed) {
+		return 1;
+	}
+
+	while (true) {
+		// main process waits for query and sends it to others
+		int connection = -1;
+		string query;
+		const char *error = NULL;
+		if (rank == PROC_MAIN) {
+			connection = accept(listener, NULL, NULL);
+			if (connection >= 0) {
+				try {
+					query = read_query(connection);
+				} catch (const char *read_error) {
+					error = read_error;
+				}
+			}
+		}
+		int length = query.length();
+		idle_bcast(&length, 1, MPI_INT, rank);
+		query.resize(length);
+		MPI_Bcast(&query[0],length,MPI_CHAR,PROC_MAIN,MPI_COMM_WORLD);
+		if (query == SERVER_STOP) {
+			if (rank == PROC_MAIN) {
+				close(connection);
+			}
+			break;
+		}
+
+		// output of main process goes to client while query runs
+		int saved_stdout = -1, saved_stderr = -1;
+		if (rank == PROC_MAIN && connection >= 0) {
+			fflush(stdout);
+			fflush(stderr);
+			saved_stdout = dup(STDOUT_FILENO);
+			saved_stderr = dup(STDERR_FILENO);
+			dup2(connection, STDOUT_FILENO);
+			dup2(connection, STDERR_FILENO);
+		}
+
+		// refused query is empty for other processes
+		Options query_options = parse_query(query);
+		if (error != NULL) {
+			fprintf(stderr, "%s\n", error);
+		} else if (query_options.node_list.empty() && query_options.input_file.empty()) {
+			// empty query (or failed connection) has no answer
+		} else if (!query_options.updates.empty() || !query_options.serve.empty()) {
+			if (rank == PROC_MAIN) {
+				fprintf(stderr, "Query cannot run incremental mode or server\n");
+			}
+		} else if (query_options.input_file == INPUT_STDIN || query_options.queries == INPUT_STDIN) {
+			// standard input of server is not connection of client
+			if (rank == PROC_MAIN) {
+				fprintf(stderr, "Query cannot read standard input (give file)\n");
+			}
+		} else if (!query_options.profile.empty()) {
+			if (rank == PROC_MAIN) {
+				fprintf(stderr, "Query cannot write profile (use -p when starting server)\n");
+			}
+		} else if (!unknown_flag(query_options).empty()) {
+			if (rank == PROC_MAIN) {
+				fprintf(stderr, "Unknown flag or missing value of flag %s in query\n", unknown_flag(query_options).c_str());
+			}
+		} else if (query_options.is_local()) {
+			if (rank == PROC_MAIN) {
+				local_preorder(query_options);
+			}
+		} else {
+			mpi_preorder(query_options, rank, size);
+		}
+
+		if (rank == PROC_MAIN && connection >= 0) {
+			fflush(stdout);
+			fflush(stderr);
+			dup2(saved_stdout, STDOUT_FILENO);
+			dup2(saved_stderr, STDERR_FILENO);
+			close(saved_stdout);
+			close(saved_stderr);
+			close(connection);
+		}
+	}
+
+	if (rank == PROC_MAIN) {
+		close(listener);
+		unlink(options.serve.c_str());
+	}
+	return 0;
+}
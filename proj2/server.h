@@ -0,0 +1,61 @@
+/**
+ * @file server.h
+ * @author Jiri Kristof, <xkrist22@stud.fit.vutbr.cz>
+ * @brief header file of server mode of project "preorder tree"
+ *
+ * processes are started once and then answer many queries, so cost
+ * of mpirun and MPI_Init is paid only once, main process accepts
+ * queries on UNIX socket and sends them to other processes, then all
+ * processes run same phases as for single tree (in MPI_COMM_WORLD,
+ * which is reused by every query)
+ */
+
+#ifndef SERVER_H
+#define SERVER_H
+
+#include "pro.h"
+
+// query stopping server
+#define SERVER_STOP "--stop"
+
+// maximal number of waiting connections
+#define SERVER_BACKLOG 16
+
+// seconds main process waits for line of connected client
+#define SERVER_TIMEOUT 5
+
+// maximal length of query line (without end of line)
+#define SERVER_MAX_QUERY 4096
+
+// microseconds idle process sleeps between checks for next query
+#define SERVER_POLL_US 1000
+
+/**
+ * Function splits query to arguments and parses them
+ * @param query line with arguments (same as on command line)
+ * @return settings of query
+ */
+Options parse_query(string query);
+
+/**
+ * Function answers queries sent to UNIX socket until stop query comes
+ * (collective, every process must call it)
+ *
+ * client connects, sends one line with arguments (for example
+ * "-b ABCDEFG" or "-c pre,size -i tree.txt") and reads result (and
+ * error messages) until server closes connection (for example by
+ * "echo -b ABCDEFG | nc -U SOCKET"), line SERVER_STOP stops server,
+ * queries of incremental mode, queries reading standard input (- for
+ * -i or -q, it is not connection of client), queries with -p (profile
+ * is given for whole server) and queries with unknown flags are
+ * refused, line not ended in SERVER_TIMEOUT seconds or longer than
+ * SERVER_MAX_QUERY is refused too, other processes sleep between
+ * queries instead of spinning in broadcast
+ * @param options settings given on command line (path of socket)
+ * @param rank rank of calling process
+ * @param size total number of processes
+ * @return exit code of program
+ */
+int serve(Options options, int rank, int size);
+
+#endif
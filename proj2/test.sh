@@ -1,18 +1,24 @@
 #!/bin/bash
 
 # setup
+# usage: test.sh SEQUENCE [PROCNUM]
+# if PROCNUM is given, edges are distributed in blocks to PROCNUM processes
 SEQUENCE=$1
 SEQLEN=${#SEQUENCE}
 PROCNUM=$(((2*SEQLEN)-1))
+FLAGS=""
 if (( PROCNUM < 0 )); then
 	PROCNUM=1
 fi
+if [ -n "$2" ]; then
+	PROCNUM=$2
+	FLAGS="-b"
+fi
 
 # compile
-mpic++ --prefix /usr/local/share/OpenMPI -o  pro pro.cpp
+mpic++ --prefix /usr/local/share/OpenMPI -pthread -o  pro pro.cpp threads.cpp tree.cpp profile.cpp engine.cpp kernel.cpp incremental.cpp server.cpp lca.cpp
 
 # execute
-mpirun -oversubscribe --prefix /usr/local/share/OpenMPI -np $PROCNUM pro $SEQUENCE
+mpirun -oversubscribe --prefix /usr/local/share/OpenMPI -np $PROCNUM pro $FLAGS $SEQUENCE
 # teardown
 rm -f pro
-
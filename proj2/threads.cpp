@@ -0,0 +1,199 @@
+/**
+ * @file threads.cpp
+ * @author Jiri Kristof <xkrist22@stud.fit.vutbr.cz>
+ * @brief File contains shared memory (multithreaded) implementation of algorithm "preorder tree"
+ */
+
+#include "threads.h"
+
+using namespace std;
+
+Barrier::Barrier(int count) {
+	this->count = count;
+	this->waiting = 0;
+	this->generation = 0;
+}
+
+void Barrier::wait() {
+	unique_lock<mutex> guard(this->lock);
+	int generation = this->generation;
+	this->waiting++;
+	if (this->waiting == this->count) {
+		// last thread releases others
+		this->waiting = 0;
+		this->generation++;
+		this->cond.notify_all();
+		return;
+	}
+	this->cond.wait(guard, [&] { return generation != this->generation; });
+}
+
+Thread_pool::Thread_pool(int size) : barrier(size) {
+	this->size = size;
+	this->generation = 0;
+	this->running = 0;
+	this->stop = false;
+	for (int i = 0; i < size; i++) {
+		this->workers.push_back(thread(&Thread_pool::worker, this, i));
+	}
+}
+
+Thread_pool::~Thread_pool() {
+	{
+		lock_guard<mutex> guard(this->lock);
+		this->stop = true;
+	}
+	this->task_cond.notify_all();
+	for (int i = 0; i < this->workers.size(); i++) {
+		this->workers[i].join();
+	}
+}
+
+void Thread_pool::worker(int id) {
+	int generation = 0;
+	while (true) {
+		function<void(int)> task;
+		{
+			// wait for new task (or for stop)
+			unique_lock<mutex> guard(this->lock);
+			this->task_cond.wait(guard, [&] { return this->stop || this->generation != generation; });
+			if (this->stop) {
+				return;
+			}
+			generation = this->generation;
+			task = this->task;
+		}
+		task(id);
+		{
+			lock_guard<mutex> guard(this->lock);
+			this->running--;
+			if (this->running == 0) {
+				this->done_cond.notify_one();
+			}
+		}
+	}
+}
+
+int Thread_pool::get_size() {
+	return this->size;
+}
+
+void Thread_pool::run(function<void(int)> task) {
+	unique_lock<mutex> guard(this->lock);
+	this->task = task;
+	this->running = this->size;
+	this->generation++;
+	this->task_cond.notify_all();
+	this->done_cond.wait(guard, [&] { return this->running == 0; });
+}
+
+index_t Thread_pool::chunk_begin(int id, index_t begin, index_t end) {
+	return begin + (index_t) (((__int128) id * (end - begin)) / this->size);
+}
+
+void Thread_pool::parallel_for(index_t begin, index_t end, function<void(index_t)> body) {
+	this->run([&](int id) {
+		index_t chunk_end = this->chunk_begin(id + 1, begin, end);
+		for (index_t i = this->chunk_begin(id, begin, end); i < chunk_end; i++) {
+			body(i);
+		}
+	});
+}
+
+void Thread_pool::sync() {
+	this->barrier.wait();
+}
+
+void thread_preorder(Options options, const Tree &tree) {
+	index_t node_count = tree.get_node_count();
+
+	// tree with only root has no edges
+	if (node_count == 1) {
+		tree.print(vector<index_t>(1, tree.get_root()));
+		return;
+	}
+
+	index_t edge_count = 2 * (node_count - 1);
+	Thread_pool pool = Thread_pool(options.threads);
+
+	/**** CREATE ADJ LIST ****/
+	// without adj list, tree is taken as implicit heap
+	Edge_store edges;
+	if (options.adjacency) {
+		edges = Edge_store(tree, "", &pool);
+	}
+
+	/**** EULER TOUR ****/
+	// arrays are indexed by id of edge - 1
+	vector<index_t> euler_tour(edge_count);
+	pool.parallel_for(0, edge_count, [&](index_t i) {
+		if (options.adjacency) {
+			euler_tour[i] = utility::euler_tour(i + 1, edges);
+		} else {
+			euler_tour[i] = utility::heap_euler_tour(i + 1, node_count);
+		}
+	});
+
+	/**** SET WEIGHTS ****/
+	vector<index_t> weight(edge_count);
+	vector<char> forward(edge_count);
+	pool.parallel_for(0, edge_count, [&](index_t i) {
+		if (options.adjacency) {
+			forward[i] = utility::is_forward(i + 1, edges);
+		} else {
+			forward[i] = utility::heap_is_forward(i + 1);
+		}
+		weight[i] = forward[i] ? 1 : 0;
+	});
+
+	/**** SUM OF SUFFIX ****/
+	// pointer jumping with two buffers, values of round are read from
+	// one buffer and written to second one, rounds are separated by barrier
+	vector<index_t> weight_next(edge_count);
+	vector<index_t> euler_tour_next(edge_count);
+	int rounds = utility::pointer_jumping_rounds(edge_count);
+	pool.run([&](int id) {
+		index_t begin = pool.chunk_begin(id, 0, edge_count);
+		index_t end = pool.chunk_begin(id + 1, 0, edge_count);
+		vector<index_t> *weight_old = &weight, *weight_new = &weight_next;
+		vector<index_t> *next_old = &euler_tour, *next_new = &euler_tour_next;
+		for (int round = 0; round <= rounds; round++) {
+			for (index_t i = begin; i < end; i++) {
+				index_t next = (*next_old)[i];
+				if (next == i + 1) {
+					(*weight_new)[i] = (*weight_old)[i];
+					(*next_new)[i] = next;
+				} else {
+					(*weight_new)[i] = (*weight_old)[i] + (*weight_old)[next - 1];
+					(*next_new)[i] = (*next_old)[next - 1];
+				}
+			}
+			swap(weight_old, weight_new);
+			swap(next_old, next_new);
+			pool.sync();
+		}
+	});
+	// result of last round is in second buffer, if number of rounds is odd
+	if ((rounds + 1) % 2 == 1) {
+		weight.swap(weight_next);
+	}
+
+	/**** PREORDER ****/
+	// every forward edge places its end node to its position
+	vector<index_t> result(node_count);
+	result[0] = tree.get_root();
+	pool.parallel_for(0, edge_count, [&](index_t i) {
+		if (!forward[i]) {
+			return;
+		}
+		index_t position = utility::preorder(weight[i], node_count);
+		if (options.adjacency) {
+			result[position] = edges.get_target(i + 1);
+		} else {
+			result[position] = utility::heap_edge_end(i + 1);
+		}
+	});
+
+	/**** PRINT RESULT ****/
+	tree.print(result);
+}
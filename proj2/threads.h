@@ -0,0 +1,121 @@
+/**
+ * @file threads.h
+ * @author Jiri Kristof, <xkrist22@stud.fit.vutbr.cz>
+ * @brief header file of shared memory (multithreaded) backend of project "preorder tree"
+ */
+
+#ifndef THREADS_H
+#define THREADS_H
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include "pro.h"
+
+/**
+ * Class implements reusable barrier for fixed number of threads
+ */
+class Barrier {
+	private:
+		int count;
+		int waiting;
+		int generation;
+		mutex lock;
+		condition_variable cond;
+	public:
+		/**
+		 * Constructor of barrier
+		 * @param count number of threads, which must reach barrier
+		 */
+		Barrier(int count);
+
+		/**
+		 * Method blocks calling thread until all threads reach barrier
+		 */
+		void wait();
+};
+
+/**
+ * Class implements pool of threads working over shared arrays
+ *
+ * threads are created once and every task is run by all of them,
+ * task gets id of thread, so it can select its part of work
+ */
+class Thread_pool {
+	private:
+		int size;
+		vector<thread> workers;
+		function<void(int)> task;
+		int generation;
+		int running;
+		bool stop;
+		mutex lock;
+		condition_variable task_cond;
+		condition_variable done_cond;
+		Barrier barrier;
+
+		/**
+		 * Method is main loop of worker thread
+		 * @param id id of worker thread
+		 */
+		void worker(int id);
+	public:
+		/**
+		 * Constructor creates worker threads
+		 * @param size number of threads
+		 */
+		Thread_pool(int size);
+
+		/**
+		 * Destructor stops and joins worker threads
+		 */
+		~Thread_pool();
+
+		/**
+		 * Getter of number of threads
+		 * @return number of threads in pool
+		 */
+		int get_size();
+
+		/**
+		 * Method runs task by every thread and waits until all threads finish
+		 * @param task function called with id of thread
+		 */
+		void run(function<void(int)> task);
+
+		/**
+		 * Method runs body for every index in range, range is split
+		 * into contiguous chunks (one for each thread)
+		 * @param begin first index
+		 * @param end index after last index
+		 * @param body function called with index
+		 */
+		void parallel_for(index_t begin, index_t end, function<void(index_t)> body);
+
+		/**
+		 * Method blocks calling thread until all threads of pool
+		 * reach it (can be called only inside task)
+		 */
+		void sync();
+
+		/**
+		 * Method returns first index of chunk of thread
+		 * @param id id of thread
+		 * @param begin first index of range
+		 * @param end index after last index of range
+		 * @return first index, which belongs to thread
+		 */
+		index_t chunk_begin(int id, index_t begin, index_t end);
+};
+
+/**
+ * Function computes preorder by threads sharing arrays of edges,
+ * phases are same as in MPI version, but no process (and no MPI
+ * function) is used
+ * @param options settings given on command line
+ * @param tree input tree
+ */
+void thread_preorder(Options options, const Tree &tree);
+
+#endif
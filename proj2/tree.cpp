@@ -0,0 +1,450 @@
+/**
+ * @file tree.cpp
+ * @author Jiri Kristof <xkrist22@stud.fit.vutbr.cz>
+ * @brief File contains input tree representation of project "preorder tree"
+ */
+
+#include <string.h>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include "tree.h"
+
+using namespace std;
+
+Tree::Tree() {
+	this->node_count = 0;
+	this->root = 0;
+	this->heap = false;
+	this->distributed = false;
+	this->slice_first = 0;
+}
+
+Tree::Tree(string node_list) {
+	this->node_count = node_list.length();
+	this->root = 0;
+	this->names = node_list;
+	this->roots.assign(1, 0);
+	this->heap = true;
+	this->distributed = false;
+	this->slice_first = 0;
+	this->parent = Mapped_array<index_t>(this->node_count);
+	this->parent[0] = NO_PARENT;
+	for (index_t i = 1; i < this->node_count; i++) {
+		this->parent[i] = (i - 1) / 2;
+	}
+}
+
+void Tree::set_parents(Mapped_array<index_t> parent, bool forest, string scratch) {
+	this->node_count = parent.size();
+	this->roots.clear();
+	if (this->node_count == 0) {
+		throw "Tree has no node";
+	}
+	if (this->node_count > MAX_NODE_COUNT) {
+		throw "Tree is too big";
+	}
+	for (index_t i = 0; i < this->node_count; i++) {
+		if (parent[i] == NO_PARENT) {
+			if (!this->roots.empty() && !forest) {
+				throw "Tree has more than one root";
+			}
+			this->roots.push_back(i);
+		} else if (parent[i] < 0 || parent[i] >= this->node_count || parent[i] == i) {
+			throw "Invalid parent of node";
+		}
+	}
+	if (this->roots.empty()) {
+		throw "Tree has no root";
+	}
+	this->root = this->roots[0];
+
+	// every node must reach root (else there is cycle), walk from
+	// every node stops on first node already known to reach root
+	Mapped_array<char> state = Mapped_array<char>(this->node_count, scratch.empty() ? "" : scratch + SCRATCH_STATE);
+	for (size_t i = 0; i < this->roots.size(); i++) {
+		state[this->roots[i]] = 2;
+	}
+	for (index_t i = 0; i < this->node_count; i++) {
+		index_t node = i;
+		while (state[node] == 0) {
+			state[node] = 1;
+			node = parent[node];
+		}
+		if (state[node] == 1) {
+			throw "Input is not a tree (cycle found)";
+		}
+		for (node = i; state[node] == 1; node = parent[node]) {
+			state[node] = 2;
+		}
+	}
+	this->parent = parent;
+}
+
+Tree Tree::read(string file_name, string format, bool forest, string scratch) {
+	bool wide = format == FORMAT_PARENTS_BIN64 || format == FORMAT_EDGES_BIN64;
+	bool binary = wide || format == FORMAT_PARENTS_BIN || format == FORMAT_EDGES_BIN;
+	bool edges = format == FORMAT_EDGES || format == FORMAT_EDGES_BIN || format == FORMAT_EDGES_BIN64;
+	if (!binary && !edges && format != FORMAT_PARENTS) {
+		throw "Unknown input format";
+	}
+
+	ifstream file;
+	istream *input = &cin;
+	if (file_name != INPUT_STDIN) {
+		file.open(file_name, binary ? ios::in | ios::binary : ios::in);
+		if (!file.is_open()) {
+			throw "Cannot open input file";
+		}
+		input = &file;
+	}
+
+	// all formats are sequences of integers, first one is number of
+	// nodes, values are streamed to parent array (binary values are
+	// read in chunks, rest of value is kept for next chunk)
+	vector<char> buffer;
+	size_t position = 0;
+	size_t width = wide ? sizeof(int64_t) : sizeof(int32_t);
+	auto next = [&](long long &value) -> bool {
+		if (!binary) {
+			return (bool) (*input >> value);
+		}
+		if (position + width > buffer.size()) {
+			buffer.erase(buffer.begin(), buffer.begin() + position);
+			position = 0;
+			size_t kept = buffer.size();
+			buffer.resize(kept + READ_CHUNK);
+			input->read(buffer.data() + kept, READ_CHUNK);
+			buffer.resize(kept + input->gcount());
+			if (buffer.size() < width) {
+				return false;
+			}
+		}
+		if (wide) {
+			int64_t number;
+			memcpy(&number, buffer.data() + position, width);
+			value = number;
+		} else {
+			int32_t number;
+			memcpy(&number, buffer.data() + position, width);
+			value = number;
+		}
+		position += width;
+		return true;
+	};
+	// missing value is error of length, if whole input was read
+	auto missing = [&]() -> const char * {
+		return !binary && !input->eof() ? "Input contains non-integer value" : "Invalid length of input";
+	};
+
+	long long value;
+	if (!next(value)) {
+		throw !binary && !input->eof() ? "Input contains non-integer value" : "Invalid number of nodes";
+	}
+	if (value < 1) {
+		throw "Invalid number of nodes";
+	}
+	if (value > MAX_NODE_COUNT) {
+		throw "Tree is too big";
+	}
+	index_t node_count = value;
+
+	Mapped_array<index_t> parent = Mapped_array<index_t>(node_count, scratch.empty() ? "" : scratch + SCRATCH_PARENT);
+	if (edges) {
+		for (index_t i = 0; i < node_count; i++) {
+			parent[i] = NO_PARENT;
+		}
+		for (index_t i = 1; i < node_count; i++) {
+			long long from, to;
+			if (!next(from) || !next(to)) {
+				throw missing();
+			}
+			if (to < 0 || to >= node_count || parent[to] != NO_PARENT) {
+				throw "Invalid edge in input";
+			}
+			if (from < 0 || from >= node_count) {
+				throw "Invalid parent of node";
+			}
+			parent[to] = from;
+		}
+	} else {
+		for (index_t i = 0; i < node_count; i++) {
+			if (!next(value)) {
+				throw missing();
+			}
+			if (value < NO_PARENT || value >= node_count) {
+				throw "Invalid parent of node";
+			}
+			parent[i] = value;
+		}
+	}
+	if (next(value) || (binary && position != buffer.size())) {
+		throw "Invalid length of input";
+	}
+	if (!binary && !input->eof()) {
+		throw "Input contains non-integer value";
+	}
+
+	Tree tree;
+	tree.set_parents(parent, forest, scratch);
+	return tree;
+}
+
+Tree Tree::forest(vector<string> node_lists) {
+	// heaps follow each other, ids of every heap are shifted by its offset
+	Tree tree;
+	for (int i = 0; i < node_lists.size(); i++) {
+		tree.names += node_lists[i];
+	}
+	Mapped_array<index_t> parent = Mapped_array<index_t>(tree.names.length());
+	index_t offset = 0;
+	for (int i = 0; i < node_lists.size(); i++) {
+		for (index_t j = 0; j < node_lists[i].length(); j++) {
+			parent[offset + j] = j == 0 ? NO_PARENT : offset + (j - 1) / 2;
+		}
+		offset += node_lists[i].length();
+	}
+	tree.set_parents(parent, true);
+	return tree;
+}
+
+/**
+ * Function reads values of file by all processes (collective), values
+ * are read in pieces of at most MESSAGE_MAX_BYTES
+ * @param file opened file
+ * @param offset offset of first value in file
+ * @param buffer buffer for values
+ * @param count number of values read by calling process
+ * @param width size of one value
+ */
+static void read_values(MPI_File file, MPI_Offset offset, char *buffer, index_t count, int width) {
+	index_t piece = MESSAGE_MAX_BYTES / width;
+	long long pieces = (count + piece - 1) / piece;
+	MPI_Allreduce(MPI_IN_PLACE, &pieces, 1, MPI_LONG_LONG, MPI_MAX, MPI_COMM_WORLD);
+	for (long long i = 0; i < pieces; i++) {
+		index_t begin = min(count, (index_t) i * piece);
+		index_t end = min(count, begin + piece);
+		MPI_File_read_at_all(file, offset + (MPI_Offset) begin * width, buffer + (size_t) begin * width,
+			(end - begin) * width, MPI_BYTE, MPI_STATUS_IGNORE);
+	}
+}
+
+Tree Tree::read_parallel(string file_name, string format, int rank, int size) {
+	if (format != FORMAT_PARENTS_BIN && format != FORMAT_PARENTS_BIN64) {
+		throw "Parallel input supports only parents-bin and parents-bin64 formats";
+	}
+	if (file_name == INPUT_STDIN) {
+		throw "Parallel input cannot read standard input";
+	}
+	MPI_File file;
+	if (MPI_File_open(MPI_COMM_WORLD, file_name.c_str(), MPI_MODE_RDONLY, MPI_INFO_NULL, &file) != MPI_SUCCESS) {
+		throw "Cannot open input file";
+	}
+
+	// every process reads number of nodes and checks size of file
+	int width = format == FORMAT_PARENTS_BIN64 ? sizeof(int64_t) : sizeof(int32_t);
+	int64_t node_count = 0;
+	int32_t narrow_count = 0;
+	MPI_Offset file_size;
+	MPI_File_get_size(file, &file_size);
+	if (width == sizeof(int64_t)) {
+		MPI_File_read_at_all(file, 0, &node_count, 1, MPI_INT64_T, MPI_STATUS_IGNORE);
+	} else {
+		MPI_File_read_at_all(file, 0, &narrow_count, 1, MPI_INT32_T, MPI_STATUS_IGNORE);
+		node_count = narrow_count;
+	}
+	if (file_size < (MPI_Offset) width || node_count < 1) {
+		MPI_File_close(&file);
+		throw "Invalid number of nodes";
+	}
+	if (node_count > MAX_NODE_COUNT) {
+		MPI_File_close(&file);
+		throw "Tree is too big";
+	}
+	if (file_size != (MPI_Offset) width * (node_count + 1)) {
+		MPI_File_close(&file);
+		throw "Invalid length of input";
+	}
+
+	// slice of parent array owned by process
+	Tree tree;
+	tree.node_count = node_count;
+	tree.distributed = true;
+	tree.slice_first = (index_t) (((__int128) rank * node_count) / size);
+	index_t slice_end = (index_t) (((__int128) (rank + 1) * node_count) / size);
+	index_t slice_count = slice_end - tree.slice_first;
+	tree.parent = Mapped_array<index_t>(slice_count);
+	MPI_Offset offset = (MPI_Offset) width * (tree.slice_first + 1);
+	if (width == sizeof(index_t)) {
+		read_values(file, offset, (char *) tree.parent.data(), slice_count, width);
+	} else if (width == sizeof(int32_t)) {
+		vector<int32_t> values(slice_count);
+		read_values(file, offset, (char *) values.data(), slice_count, width);
+		copy(values.begin(), values.end(), tree.parent.data());
+	} else {
+		vector<int64_t> values(slice_count);
+		read_values(file, offset, (char *) values.data(), slice_count, width);
+		copy(values.begin(), values.end(), tree.parent.data());
+	}
+	MPI_File_close(&file);
+
+	// errors are reduced, so every process throws same error
+	index_t roots = 0, root = -1;
+	int invalid = 0;
+	for (index_t i = 0; i < slice_count; i++) {
+		index_t node = tree.slice_first + i;
+		if (tree.parent[i] == NO_PARENT) {
+			roots++;
+			root = node;
+		} else if (tree.parent[i] < 0 || tree.parent[i] >= node_count || tree.parent[i] == node) {
+			invalid = 1;
+		}
+	}
+	MPI_Allreduce(MPI_IN_PLACE, &roots, 1, MPI_INDEX, MPI_SUM, MPI_COMM_WORLD);
+	MPI_Allreduce(MPI_IN_PLACE, &root, 1, MPI_INDEX, MPI_MAX, MPI_COMM_WORLD);
+	MPI_Allreduce(MPI_IN_PLACE, &invalid, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+	if (invalid) {
+		throw "Invalid parent of node";
+	}
+	if (roots == 0) {
+		throw "Tree has no root";
+	}
+	if (roots > 1) {
+		throw "Tree has more than one root";
+	}
+	tree.root = root;
+	tree.roots.assign(1, root);
+	return tree;
+}
+
+void Tree::broadcast() {
+	index_t shape[3] = {this->node_count, this->root, (index_t) this->roots.size()};
+	MPI_Bcast(shape,3,MPI_INDEX,0,MPI_COMM_WORLD);
+	this->node_count = shape[0];
+	this->root = shape[1];
+	this->roots.resize(shape[2]);
+	// roots of big forest are sent in pieces
+	size_t piece = MESSAGE_MAX_BYTES / sizeof(index_t);
+	for (size_t begin = 0; begin < this->roots.size(); begin += piece) {
+		int count = min(piece, this->roots.size() - begin);
+		MPI_Bcast(this->roots.data() + begin,count,MPI_INDEX,0,MPI_COMM_WORLD);
+	}
+}
+
+index_t Tree::get_node_count() const {
+	return this->node_count;
+}
+
+index_t Tree::get_root() const {
+	return this->root;
+}
+
+const vector<index_t> &Tree::get_roots() const {
+	return this->roots;
+}
+
+vector<index_t> Tree::root_of() const {
+	// walk from node stops on first node with known root, then
+	// root is written to every node of walk
+	vector<index_t> result(this->node_count, -1);
+	for (size_t i = 0; i < this->roots.size(); i++) {
+		result[this->roots[i]] = this->roots[i];
+	}
+	for (index_t i = 0; i < this->node_count; i++) {
+		index_t node = i;
+		while (result[node] == -1) {
+			node = this->parent[node];
+		}
+		for (index_t walk = i; result[walk] == -1; walk = this->parent[walk]) {
+			result[walk] = result[node];
+		}
+	}
+	return result;
+}
+
+index_t Tree::get_parent(index_t node) const {
+	return this->parent[node - this->slice_first];
+}
+
+bool Tree::is_distributed() const {
+	return this->distributed;
+}
+
+index_t Tree::get_slice_first() const {
+	return this->slice_first;
+}
+
+index_t Tree::get_slice_count() const {
+	return this->parent.size();
+}
+
+bool Tree::is_heap() const {
+	return this->heap;
+}
+
+index_t Tree::edge_slot(index_t node) const {
+	if (this->roots.size() <= 1) {
+		return node < this->root ? node + 1 : node;
+	}
+	// every root before node frees one slot
+	return node + 1 - (upper_bound(this->roots.begin(), this->roots.end(), node) - this->roots.begin());
+}
+
+index_t Tree::slot_node(index_t slot) const {
+	if (this->roots.size() <= 1) {
+		return slot <= this->root ? slot - 1 : slot;
+	}
+	// root i has i roots before it, so it is preceded by roots[i] - i
+	// slots, node is shifted by number of roots preceded by fewer slots
+	index_t low = 0, high = this->roots.size();
+	while (low < high) {
+		index_t middle = (low + high) / 2;
+		if (this->roots[middle] - middle <= slot - 1) {
+			low = middle + 1;
+		} else {
+			high = middle;
+		}
+	}
+	return slot - 1 + low;
+}
+
+string Tree::label(index_t node) const {
+	if (node < this->names.length()) {
+		return string(1, this->names[node]);
+	} else if (!this->names.empty()) {
+		// chars are printed without separator, so id is delimited
+		return ADDED_NODE_OPEN + to_string(node) + ADDED_NODE_CLOSE;
+	}
+	return to_string(node);
+}
+
+void Tree::print(const vector<index_t> &order) const {
+	this->print(order.data(), order.size());
+}
+
+void Tree::print(const index_t *order, size_t count) const {
+	// output is written in chunks, so it is not built in memory at once
+	string result;
+	for (size_t i = 0; i < count; i++) {
+		if (!this->names.empty()) {
+			// nodes added after reading (see Incremental_preorder) have
+			// no char, they are printed as delimited ids
+			if (order[i] < this->names.length()) {
+				result += this->names[order[i]];
+			} else {
+				result += this->label(order[i]);
+			}
+		} else {
+			if (i > 0) {
+				result += ' ';
+			}
+			result += to_string(order[i]);
+		}
+		if ((i + 1) % PRINT_CHUNK == 0) {
+			fwrite(result.data(), 1, result.size(), stdout);
+			result.clear();
+		}
+	}
+	result += '\n';
+	fwrite(result.data(), 1, result.size(), stdout);
+}
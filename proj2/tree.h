@@ -0,0 +1,260 @@
+/**
+ * @file tree.h
+ * @author Jiri Kristof, <xkrist22@stud.fit.vutbr.cz>
+ * @brief header file of input tree representation of project "preorder tree"
+ */
+
+#ifndef TREE_H
+#define TREE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <mpi.h>
+#include <string>
+#include <vector>
+#include "mapped.h"
+
+// input formats
+#define FORMAT_PARENTS "parents"
+#define FORMAT_EDGES "edges"
+#define FORMAT_PARENTS_BIN "parents-bin"
+#define FORMAT_EDGES_BIN "edges-bin"
+#define FORMAT_PARENTS_BIN64 "parents-bin64"
+#define FORMAT_EDGES_BIN64 "edges-bin64"
+
+// name of input file meaning standard input
+#define INPUT_STDIN "-"
+
+// parent of root in parent array
+#define NO_PARENT -1
+
+// delimiters of id of node added to sequence tree (it has no char)
+#define ADDED_NODE_OPEN "["
+#define ADDED_NODE_CLOSE "]"
+
+// ids of nodes and edges, counts and sums of euler tour are 64-bit,
+// build with -DINDEX32 halves memory, but limits tree to 2^30 nodes
+// (edge ids 1..2n - 2 and block bounds must fit to index)
+#ifdef INDEX32
+typedef int32_t index_t;
+#define MPI_INDEX MPI_INT32_T
+#define MAX_NODE_COUNT ((index_t) 1 << 30)
+#else
+typedef int64_t index_t;
+#define MPI_INDEX MPI_INT64_T
+#define MAX_NODE_COUNT ((index_t) 1 << 61)
+#endif
+
+// largest number of bytes given to one MPI call (counts and
+// displacements of MPI are int), longer arrays are sent or read in
+// pieces (can be lowered by -DMESSAGE_MAX_BYTES=...)
+#ifndef MESSAGE_MAX_BYTES
+#define MESSAGE_MAX_BYTES (1 << 30)
+#endif
+
+// number of nodes printed by one write and bytes of binary input read
+// by one read
+#define PRINT_CHUNK 65536
+#define READ_CHUNK 65536
+
+// suffixes of scratch files of parent array and of check of tree
+#define SCRATCH_PARENT ".parent"
+#define SCRATCH_STATE ".state"
+
+using namespace std;
+
+/**
+ * Class represents rooted tree with nodes identified by ids 0..n-1
+ *
+ * tree is given either by sequence of chars (implicit heap, children of
+ * node i are 2i+1 and 2i+2, node is printed as its char) or read from
+ * file as parent array or edge list of integer ids (node is printed as
+ * its id)
+ *
+ * supported input formats:
+ *   parents      text, n followed by n parents (root has parent -1)
+ *   edges        text, n followed by n - 1 pairs "parent child"
+ *   parents-bin  same as parents, but 32-bit integers in binary form
+ *   edges-bin    same as edges, but 32-bit integers in binary form
+ *   parents-bin64, edges-bin64  same with 64-bit integers (for trees
+ *                with more than 2^31 nodes)
+ *
+ * children of node are ordered by their ids, so sequence and parent
+ * array of implicit heap give same preorder
+ *
+ * forest has more roots (in parent array, or one heap per sequence
+ * with ids following ids of previous sequence), edges of all trees
+ * share one numbering of slots (see edge_slot)
+ *
+ * parent array read from file can be mapped to scratch file (see
+ * Mapped_array), then input is streamed to it and reading holds no
+ * array of size of tree in memory
+ */
+class Tree {
+	private:
+		index_t node_count;
+		index_t root;
+		vector<index_t> roots;
+		Mapped_array<index_t> parent;
+		string names;
+		bool heap;
+		bool distributed;
+		index_t slice_first;
+
+		/**
+		 * Method sets parent array and checks, if it describes tree
+		 * @param parent parent of every node (NO_PARENT for root)
+		 * @param forest true, if more roots are allowed
+		 * @param scratch prefix of scratch file for state of check
+		 *		(empty for memory)
+		 */
+		void set_parents(Mapped_array<index_t> parent, bool forest = false, string scratch = "");
+	public:
+		/**
+		 * Constructor of empty tree
+		 */
+		Tree();
+
+		/**
+		 * Constructor of tree given by sequence (implicit heap)
+		 * @param node_list sequence of names of nodes
+		 */
+		Tree(string node_list);
+
+		/**
+		 * Method reads tree from file, values are streamed directly
+		 * to parent array
+		 * @param file_name name of file (INPUT_STDIN for standard input)
+		 * @param format one of supported formats
+		 * @param forest true, if more roots are allowed
+		 * @param scratch prefix of scratch files of parent array and
+		 *		check (empty for memory)
+		 * @return read tree
+		 */
+		static Tree read(string file_name, string format, bool forest = false, string scratch = "");
+
+		/**
+		 * Method creates forest of implicit heaps
+		 * @param node_lists sequence of names of nodes for every tree
+		 * @return forest with roots in first nodes of sequences
+		 */
+		static Tree forest(vector<string> node_lists);
+
+		/**
+		 * Method reads tree from binary parent array by every process
+		 * in parallel (collective), process keeps only parents of its
+		 * slice of nodes (split in same way as Edge_block splits edges),
+		 * cycles are found later (see distributed_check_tree)
+		 * @param file_name name of file
+		 * @param format format of file (only parents-bin and parents-bin64
+		 *		have fixed offsets)
+		 * @param rank rank of calling process
+		 * @param size total number of processes
+		 * @return tree with distributed parent array
+		 */
+		static Tree read_parallel(string file_name, string format, int rank, int size);
+
+		/**
+		 * Method sends number of nodes and roots of tree from main process
+		 * to others (structure of tree is sent as adj list)
+		 */
+		void broadcast();
+
+		/**
+		 * Getter of number of nodes
+		 * @return number of nodes in tree
+		 */
+		index_t get_node_count() const;
+
+		/**
+		 * Getter of root
+		 * @return id of root node (first root of forest)
+		 */
+		index_t get_root() const;
+
+		/**
+		 * Getter of roots of forest
+		 * @return ids of roots in increasing order
+		 */
+		const vector<index_t> &get_roots() const;
+
+		/**
+		 * Method finds root of tree of every node (linear time)
+		 * @return root of every node
+		 */
+		vector<index_t> root_of() const;
+
+		/**
+		 * Getter of parent of node
+		 * @param node id of node (in slice of calling process, if tree is distributed)
+		 * @return id of parent node (NO_PARENT for root)
+		 */
+		index_t get_parent(index_t node) const;
+
+		/**
+		 * Method checks, if parent array is split between processes
+		 * @return true, if tree was read in parallel
+		 */
+		bool is_distributed() const;
+
+		/**
+		 * Getter of first node, which parent is known by calling process
+		 * @return id of first node in slice (0 for not distributed tree)
+		 */
+		index_t get_slice_first() const;
+
+		/**
+		 * Getter of number of nodes, which parents are known by calling process
+		 * @return number of nodes in slice
+		 */
+		index_t get_slice_count() const;
+
+		/**
+		 * Method checks, if tree is implicit heap given by sequence
+		 * @return true, if euler tour can be derived from edge ids
+		 */
+		bool is_heap() const;
+
+		/**
+		 * Method returns index of pair of edges going to/from node,
+		 * forward edge to node has id 2 * slot - 1 and reverse edge
+		 * has id 2 * slot (in heap, slot of node is its index), roots
+		 * are skipped (so slots of forest are 1..n-r for r roots)
+		 * @param node id of node (not root)
+		 * @return slot of node (1..n-1)
+		 */
+		index_t edge_slot(index_t node) const;
+
+		/**
+		 * Method returns node, whose edges are in given slot
+		 * @param slot index of pair of edges
+		 * @return id of child node of edges
+		 */
+		index_t slot_node(index_t slot) const;
+
+		/**
+		 * Method returns printable name of node
+		 * @param node id of node
+		 * @return char of node for sequence, id for file, id between
+		 * ADDED_NODE_OPEN and ADDED_NODE_CLOSE for node added after
+		 * sequence was read
+		 */
+		string label(index_t node) const;
+
+		/**
+		 * Method prints nodes in given order (chars without separator
+		 * for sequence, ids separated by space for file, see label)
+		 * @param order ids of nodes
+		 */
+		void print(const vector<index_t> &order) const;
+
+		/**
+		 * Method prints nodes in given order as one line, output is
+		 * written in chunks, so order can be mapped file of any size
+		 * @param order ids of nodes
+		 * @param count number of nodes
+		 */
+		void print(const index_t *order, size_t count) const;
+};
+
+#endif